@@ -39,6 +39,7 @@ SOURCES = applock.cpp              \
           gunzip.cpp \
           login2.cpp \
           login2Options.cpp \
+          metasqlcache.cpp \
           metrics.cpp \
           metricsenc.cpp \
           qbase64encode.cpp \
@@ -48,6 +49,7 @@ SOURCES = applock.cpp              \
           tarfile.cpp \
           xbase32.cpp \
           xtupleproductkey.cpp \
+          xsqlconnectionpool.cpp \
           xtsettings.cpp
 HEADERS = applock.h              \
           calendarcontrol.h      \
@@ -61,6 +63,7 @@ HEADERS = applock.h              \
           gunzip.h \
           login2.h \
           login2Options.h \
+          metasqlcache.h \
           metrics.h \
           metricsenc.h \
           qbase64encode.h \
@@ -70,6 +73,7 @@ HEADERS = applock.h              \
           tarfile.h \
           xbase32.h \
           xtupleproductkey.h \
+          xsqlconnectionpool.h \
           xtsettings.h
 
 FORMS = login2.ui login2Options.ui checkForUpdates.ui
@@ -24,7 +24,7 @@
 #include <QTextDocument>
 
 #include "metasql.h"
-#include "mqlutil.h"
+#include "metasqlcache.h"
 #include "xsqlquery.h"
 
 #define DEBUG false
@@ -173,9 +173,9 @@ QString ExportHelper::generateDelimited(const int qryheadid, ParameterList &para
     {
       QString tmpmsg;
       bool valid;
-      qtext = MQLUtil::mqlLoad(itemq.value("qryitem_group").toString(),
-                               itemq.value("qryitem_detail").toString(),
-                               tmpmsg, &valid);
+      qtext = MetaSQLCache::instance()->text(itemq.value("qryitem_group").toString(),
+                                             itemq.value("qryitem_detail").toString(),
+                                             tmpmsg, &valid);
       if (! valid)
         errmsg = tmpmsg;
     }
@@ -226,8 +226,8 @@ QString ExportHelper::generateDelimited(QString qtext, ParameterList &params, QS
            includeheader, valid);
 
   QStringList line;
-  MetaSQLQuery mql(qtext);
-  XSqlQuery qry = mql.toQuery(params);
+  QSharedPointer<MetaSQLQuery> mql = MetaSQLCache::instance()->parse(qtext);
+  XSqlQuery qry = mql->toQuery(params);
   if (qry.first())
   {
     QStringList field;
@@ -287,9 +287,9 @@ QString ExportHelper::generateHTML(const int qryheadid, ParameterList &params, Q
     {
       QString tmpmsg;
       bool valid;
-      qtext = MQLUtil::mqlLoad(itemq.value("qryitem_group").toString(),
-                               itemq.value("qryitem_detail").toString(),
-                               tmpmsg, &valid);
+      qtext = MetaSQLCache::instance()->text(itemq.value("qryitem_group").toString(),
+                                             itemq.value("qryitem_detail").toString(),
+                                             tmpmsg, &valid);
       if (! valid)
         errmsg = tmpmsg;
     }
@@ -324,8 +324,8 @@ QString ExportHelper::generateHTML(QString qtext, ParameterList &params, QString
     qDebug("generateHTML(qtest, params, errmsg) includeheader = %d, valid = %d",
            includeheader, valid);
 
-  MetaSQLQuery mql(qtext);
-  XSqlQuery qry = mql.toQuery(params);
+  QSharedPointer<MetaSQLQuery> mql = MetaSQLCache::instance()->parse(qtext);
+  XSqlQuery qry = mql->toQuery(params);
   if (qry.first())
   {
     int cols = qry.record().count();
@@ -397,9 +397,9 @@ QString ExportHelper::generateXML(const int qryheadid, ParameterList &params, QS
     {
       QString tmpmsg;
       bool valid;
-      qtext = MQLUtil::mqlLoad(itemq.value("qryitem_group").toString(),
-                               itemq.value("qryitem_detail").toString(),
-                               tmpmsg, &valid);
+      qtext = MetaSQLCache::instance()->text(itemq.value("qryitem_group").toString(),
+                                             itemq.value("qryitem_detail").toString(),
+                                             tmpmsg, &valid);
       if (! valid)
         errmsg = tmpmsg;
     }
@@ -408,8 +408,8 @@ QString ExportHelper::generateXML(const int qryheadid, ParameterList &params, QS
 
     if (! qtext.isEmpty())
     {
-      MetaSQLQuery mql(qtext);
-      XSqlQuery qry = mql.toQuery(params);
+      QSharedPointer<MetaSQLQuery> mql = MetaSQLCache::instance()->parse(qtext);
+      XSqlQuery qry = mql->toQuery(params);
       if (qry.first())
       {
         do {
@@ -464,8 +464,8 @@ QString ExportHelper::generateXML(QString qtext, QString tableElemName, Paramete
 
   if (! qtext.isEmpty())
   {
-    MetaSQLQuery mql(qtext);
-    XSqlQuery qry = mql.toQuery(params);
+    QSharedPointer<MetaSQLQuery> mql = MetaSQLCache::instance()->parse(qtext);
+    XSqlQuery qry = mql->toQuery(params);
     if (qry.first())
     {
       do {
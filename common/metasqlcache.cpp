@@ -0,0 +1,118 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#include "metasqlcache.h"
+
+#include <QApplication>
+
+#include "metasql.h"
+#include "mqlutil.h"
+
+#define DEBUG false
+
+// ad hoc statements from exports can be many, so don't keep them forever
+#define MAXPARSED 256
+
+MetaSQLCache *MetaSQLCache::_instance = 0;
+
+MetaSQLCache *MetaSQLCache::instance()
+{
+  if (! _instance)
+    _instance = new MetaSQLCache(qApp);
+  return _instance;
+}
+
+MetaSQLCache::MetaSQLCache(QObject *parent)
+  : QObject(parent)
+{
+  setObjectName("MetaSQLCache");
+}
+
+MetaSQLCache::~MetaSQLCache()
+{
+  if (_instance == this)
+    _instance = 0;
+}
+
+/* return the statement MQLUtil::mqlLoad() finds for group and name.
+   failures are not cached so the next caller tries again.
+ */
+QString MetaSQLCache::text(const QString &group, const QString &name,
+                           QString &errmsg, bool *valid)
+{
+  if (_loaded.isValid() && _loaded.elapsed() > maxAge * 1000)
+    clear();
+
+  QString key = group + "/" + name;
+  QHash<QString, QString>::const_iterator it = _texts.constFind(key);
+  if (it != _texts.constEnd())
+  {
+    if (valid)
+      *valid = true;
+    return it.value();
+  }
+
+  bool    ok = false;
+  QString result = MQLUtil::mqlLoad(group, name, errmsg, &ok);
+  if (ok)
+  {
+    if (_texts.isEmpty())
+      _loaded.start();
+    _texts.insert(key, result);
+  }
+  else if (DEBUG)
+    qDebug("MetaSQLCache::text(%s) not caching after error %s",
+           qPrintable(key), qPrintable(errmsg));
+
+  if (valid)
+    *valid = ok;
+  return result;
+}
+
+QSharedPointer<MetaSQLQuery> MetaSQLCache::parse(const QString &text)
+{
+  QHash<QString, QSharedPointer<MetaSQLQuery> >::const_iterator it = _parsed.constFind(text);
+  if (it != _parsed.constEnd())
+    return it.value();
+
+  if (_parsed.size() >= MAXPARSED)
+    _parsed.clear();
+
+  QSharedPointer<MetaSQLQuery> result(new MetaSQLQuery(text));
+  _parsed.insert(text, result);
+  return result;
+}
+
+/* if the load fails the result is an empty, invalid query; check valid
+   and report errmsg before using it.
+ */
+QSharedPointer<MetaSQLQuery> MetaSQLCache::query(const QString &group, const QString &name,
+                                                 QString &errmsg, bool *valid)
+{
+  bool ok = false;
+  QString statement = text(group, name, errmsg, &ok);
+  if (valid)
+    *valid = ok;
+
+  if (! ok)
+    return QSharedPointer<MetaSQLQuery>(new MetaSQLQuery());
+
+  return parse(statement);
+}
+
+void MetaSQLCache::clear()
+{
+  if (DEBUG)
+    qDebug("MetaSQLCache::clear() dropping %d statements", _texts.size());
+
+  // parsed queries are keyed by text, so unchanged statements keep theirs
+  _texts.clear();
+  _loaded = QTime();
+}
@@ -0,0 +1,63 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#ifndef __METASQLCACHE_H__
+#define __METASQLCACHE_H__
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <QTime>
+
+class MetaSQLQuery;
+
+/* Process-wide cache in front of MQLUtil::mqlLoad().
+
+   text() remembers the statement MQLUtil::mqlLoad() picked for each
+   group and name, so refreshing a window does not fetch it again.
+   parse() keeps one parsed MetaSQLQuery per distinct statement text;
+   since it is keyed by content, an edited statement simply gets a new
+   entry. query() combines the two.
+
+   Nothing tells this client when another one edits a statement, so the
+   texts are dropped once they are maxAge seconds old, and immediately
+   when clear() is called after an edit here.
+ */
+class MetaSQLCache : public QObject
+{
+  Q_OBJECT
+
+  public:
+    static MetaSQLCache *instance();
+
+    QString                      text(const QString &group, const QString &name,
+                                      QString &errmsg, bool *valid = 0);
+    QSharedPointer<MetaSQLQuery> parse(const QString &text);
+    QSharedPointer<MetaSQLQuery> query(const QString &group, const QString &name,
+                                       QString &errmsg, bool *valid = 0);
+
+    static const int maxAge = 60;
+
+  public slots:
+    void clear();
+
+  private:
+    MetaSQLCache(QObject *parent = 0);
+    ~MetaSQLCache();
+
+    static MetaSQLCache *_instance;
+
+    QHash<QString, QString>                       _texts;  // <group/name, text>
+    QHash<QString, QSharedPointer<MetaSQLQuery> > _parsed; // <text, query>
+    QTime                                         _loaded; // when _texts was first filled
+};
+
+#endif
@@ -14,6 +14,7 @@
 #include <QSqlDatabase>
 #include <QSqlDriver>
 #include <QVariant>
+#include <QtAlgorithms>
 #include "xsqlquery.h"
 #include <QMessageBox>
 
@@ -26,13 +27,21 @@ Parameters::Parameters(QObject * parent)
 void Parameters::load()
 {
   _values.clear();
+  _keysByValue.clear();
 
   XSqlQuery q;
   q.prepare(_readSql);
   q.bindValue(":username", _username);
   q.exec();
   while (q.next())
-    _values[q.value("key").toString()] = q.value("value").toString();
+  {
+    QString key = q.value("key").toString();
+    MetricMap::iterator it = _values.find(key);
+    if (it != _values.end())
+      _unindex(key, it.value());
+    _values[key] = q.value("value").toString();
+    _index(key, _values[key]);
+  }
   if (q.lastError().type() != QSqlError::NoError) {
     QMessageBox::critical(0, tr("Error loading %1").arg(metaObject()->className()),
                          q.lastError().text());
@@ -113,11 +122,15 @@ void Parameters::set(const QString &pName, const QString &pValue)
     if (it.value() == pValue)
       return;
     else
+    {
+      _unindex(pName, it.value());
       it.value() = pValue;
+    }
   }
   else
     _values[pName] = pValue;
 
+  _index(pName, pValue);
   _set(pName, pValue);
 }
 
@@ -133,13 +146,31 @@ void Parameters::_set(const QString &pName, QVariant pValue)
   _dirty = true;
 }
 
+void Parameters::_index(const QString &pName, const QString &pValue)
+{
+  QStringList &keys = _keysByValue[pValue];
+  keys.insert(qLowerBound(keys.begin(), keys.end(), pName) - keys.begin(), pName);
+}
+
+void Parameters::_unindex(const QString &pName, const QString &pValue)
+{
+  QHash<QString, QStringList>::iterator it = _keysByValue.find(pValue);
+  if (it == _keysByValue.end())
+    return;
+
+  it.value().removeOne(pName);
+  if (it.value().isEmpty())
+    _keysByValue.erase(it);
+}
+
+// returns the first key, in key order, whose value is pValue
 QString Parameters::parent(const QString &pValue)
 {
-  for (MetricMap::iterator it = _values.begin(); it != _values.end(); it++)
-    if (it.value() == pValue)
-      return it.key();
+  QHash<QString, QStringList>::const_iterator it = _keysByValue.constFind(pValue);
+  if (it == _keysByValue.constEnd())
+    return QString::null;
 
-  return QString::null;
+  return it.value().first();
 }
 
 
@@ -177,6 +208,10 @@ void Preferences::remove(const QString &pPrefName)
 
 
 Privileges::Privileges()
+  : _generation(0),
+    _heldStale(true),
+    _dbaKnown(false),
+    _dba(false)
 {
   _notifyName = "usrprivUpdated";
   QString user;
@@ -200,48 +235,121 @@ Privileges::Privileges()
   QSqlDatabase::database().driver()->subscribeToNotification("usrprivUpdated");
   QObject::connect(QSqlDatabase::database().driver(), SIGNAL(notification(const QString&)),
            this, SLOT(sSetDirty(const QString &)));
+  QObject::connect(QSqlDatabase::database().driver(), SIGNAL(notification(const QString&)),
+           this, SLOT(sNotification(const QString &)));
+  connect(this, SIGNAL(loaded()), this, SLOT(sLoaded()));
 
   load();
 }
 
-bool Privileges::check(const QString &pName)
+void Privileges::sLoaded()
 {
-    if (pName == "#superuser")
-      return isDba();
+  _heldStale = true;
+  _generation++;
+}
 
-    if(_dirty)
-      load();
+// granting or revoking privileges may also change the DBA role
+void Privileges::sNotification(const QString &note)
+{
+  if (note == _notifyName)
+  {
+    _dbaKnown = false;
+    _generation++;
+  }
+}
 
-    MetricMap::iterator it = _values.find(pName);
-    if (it != _values.end())
-      return true;
+int Privileges::privId(const QString &pName)
+{
+  QHash<QString, int>::const_iterator it = _privIds.constFind(pName);
+  if (it != _privIds.constEnd())
+    return it.value();
 
-    if (pName.contains(" ")) {
-      QStringList privlist = pName.split(' ', QString::SkipEmptyParts);
-      foreach (QString priv, privlist) {
-        if (check(priv))
-          return true;
-      }
-    }
+  int id = _privIds.size();
+  _privIds.insert(pName, id);
+  _heldStale = true;
+  return id;
+}
+
+bool Privileges::evaluate(Expression &expr)
+{
+  if (_heldStale)
+  {
+    _held.fill(false, _privIds.size());
+    for (QHash<QString, int>::const_iterator it = _privIds.constBegin();
+         it != _privIds.constEnd(); it++)
+      if (_values.contains(it.key()))
+        _held.setBit(it.value());
+    _heldStale = false;
+  }
+
+  if (expr.generation == _generation)
+    return expr.result;
+
+  bool result = false;
+  for (int i = 0; ! result && i < expr.terms.size(); i++)
+  {
+    bool anded = true;
+    const QList<int> &term = expr.terms.at(i);
+    for (int j = 0; anded && j < term.size(); j++)
+      anded = term.at(j) < 0 ? isDba() : _held.testBit(term.at(j));
+    result = anded;
+  }
+
+  // don't remember an answer that depended on a failed isDBA() query
+  if (_dbaKnown || ! expr.usesDba)
+  {
+    expr.generation = _generation;
+    expr.result     = result;
+  }
+  return result;
+}
+
+/* Space separates alternatives and '+' joins privileges that are all
+   required, so "A B+C" means A or (B and C). #superuser may appear
+   anywhere a privilege name can.
+ */
+bool Privileges::check(const QString &pName)
+{
+  if(_dirty)
+    load();
 
-    if (pName.contains("+")) {
-      bool anded = true;
-      QStringList privlist = pName.split('+', QString::SkipEmptyParts);
-      foreach (QString priv, privlist) {
-        anded = anded && check(priv);
+  QHash<QString, Expression>::iterator it = _expressions.find(pName);
+  if (it == _expressions.end())
+  {
+    Expression expr;
+    expr.generation = -1;
+    expr.result     = false;
+    expr.usesDba    = false;
+    foreach (QString alternative, pName.split(' ', QString::SkipEmptyParts))
+    {
+      QList<int> term;
+      foreach (QString priv, alternative.split('+', QString::SkipEmptyParts))
+      {
+        if (priv == "#superuser")
+          expr.usesDba = true;
+        term.append(priv == "#superuser" ? -1 : privId(priv));
       }
-      return anded;
+      expr.terms.append(term);
     }
+    it = _expressions.insert(pName, expr);
+  }
 
- return false;
+  return evaluate(it.value());
 }
 
 bool Privileges::isDba()
 {
+  if (_dbaKnown)
+    return _dba;
+
   XSqlQuery su("SELECT isDBA() AS issuper;");
   su.exec();
   if (su.first())
-    return su.value("issuper").toBool();
+  {
+    _dba      = su.value("issuper").toBool();
+    _dbaKnown = true;
+    return _dba;
+  }
   else if (su.lastError().type() != QSqlError::NoError)
     qWarning("SQL error in Privileges::isDba(): %s",
              qPrintable(su.lastError().text()));
@@ -12,8 +12,12 @@
 #ifndef metrics_h
 #define metrics_h
 
+#include <QBitArray>
+#include <QHash>
+#include <QList>
 #include <QObject>
 #include <QString>
+#include <QStringList>
 #include <QMap>
 
 typedef QMap<QString, QString> MetricMap;
@@ -24,6 +28,7 @@ class Parameters : public QObject
 
   protected:
     MetricMap _values;
+    QHash<QString, QStringList> _keysByValue; // sorted keys holding each value
     QString   _readSql;
     QString   _setSql;
     QString   _username;
@@ -55,6 +60,8 @@ class Parameters : public QObject
 
   protected:
     void _set(const QString &, QVariant);
+    void _index(const QString &, const QString &);
+    void _unindex(const QString &, const QString &);
 
   signals:
     void loaded();
@@ -90,6 +97,34 @@ class Privileges : public Parameters
   public slots:
     bool check(const QString &);
     bool isDba();
+
+  private slots:
+    void sLoaded();
+    void sNotification(const QString &);
+
+  private:
+    /* A check() expression compiled to a list of alternatives separated
+       by spaces, each a list of privilege ids joined with '+'. The result
+       is remembered until the privileges or the DBA flag change.
+     */
+    struct Expression
+    {
+      QList<QList<int> > terms;
+      int                generation;
+      bool               result;
+      bool               usesDba;
+    };
+
+    int  privId(const QString &);
+    bool evaluate(Expression &);
+
+    QHash<QString, Expression> _expressions;
+    QHash<QString, int>        _privIds;
+    QBitArray                  _held;
+    int                        _generation;
+    bool                       _heldStale;
+    bool                       _dbaKnown;
+    bool                       _dba;
 };
 
 #endif
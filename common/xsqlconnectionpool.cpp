@@ -0,0 +1,483 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#include "xsqlconnectionpool.h"
+
+#include <QApplication>
+#include <QMutexLocker>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
+
+#define DEBUG false
+
+// how long stop() waits for each pool thread after cancelling its query
+#define STOPWAIT 5000
+
+/* one pool thread and the connection it owns */
+class XSqlConnectionPoolWorker : public QThread
+{
+  public:
+    XSqlConnectionPoolWorker(XSqlConnectionPool *pool, int number)
+      : _pool(pool), _number(number), _backendPid(-1)
+    {
+    }
+
+    // guarded by the pool's _mutex
+    int backendPid() const { return _backendPid; }
+
+  protected:
+    virtual void run()
+    {
+      QString connname = QString("XSqlConnectionPool%1").arg(_number);
+      {
+        QSqlDatabase db = QSqlDatabase::addDatabase(_pool->_driver, connname);
+        while (XSqlPoolTask *task = _pool->next())
+        {
+          if (! db.isOpen())
+          {
+            int pid = -1;
+            if (! _pool->openConnection(db, pid))
+            {
+              _pool->fallBack(task);
+              break;
+            }
+            QMutexLocker locker(&_pool->_mutex);
+            _backendPid = pid;
+          }
+          task->execute(db);
+        }
+        db.close();
+      }
+      QSqlDatabase::removeDatabase(connname);
+    }
+
+  private:
+    XSqlConnectionPool *_pool;
+    int                 _number;
+    int                 _backendPid;
+};
+
+/* the task behind XSqlConnectionPool::exec() */
+class XSqlPoolQueryTask : public XSqlPoolTask
+{
+  public:
+    XSqlPoolQueryTask(qulonglong serial, const QString &sql,
+                      const QVariantMap &bindings)
+      : _serial(serial), _sql(sql), _bindings(bindings)
+    {
+    }
+
+    qulonglong serial() const { return _serial; }
+
+  protected:
+    virtual void run(QSqlDatabase &db)
+    {
+      QStringList  columns;
+      QVariantList rows;
+      QString      error;
+
+      if (! db.isOpen())
+        error = db.lastError().text();
+      else
+      {
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        if (query.prepare(_sql))
+        {
+          QMapIterator<QString, QVariant> bind(_bindings);
+          while (bind.hasNext())
+          {
+            bind.next();
+            query.bindValue(bind.key(), bind.value());
+          }
+          query.exec();
+        }
+
+        if (query.lastError().type() != QSqlError::NoError)
+          error = query.lastError().text();
+        else
+          XSqlConnectionPool::read(query, columns, rows);
+      }
+
+      if (DEBUG)
+        qDebug("XSqlPoolQueryTask::run() %llu found %d rows %s",
+               _serial, rows.size(), qPrintable(error));
+      emit XSqlConnectionPool::instance()->queryFinished(_serial, columns,
+                                                         rows, error);
+    }
+
+  private:
+    qulonglong  _serial;
+    QString     _sql;
+    QVariantMap _bindings;
+};
+
+XSqlPoolTask::XSqlPoolTask(QObject *parent)
+  : QObject(parent),
+    _finished(false),
+    _deleteWhenFinished(false)
+{
+}
+
+XSqlPoolTask::~XSqlPoolTask()
+{
+}
+
+void XSqlPoolTask::start()
+{
+  XSqlConnectionPool::instance()->start(this);
+}
+
+bool XSqlPoolTask::isFinished() const
+{
+  QMutexLocker locker(&_stateMutex);
+  return _finished;
+}
+
+bool XSqlPoolTask::wait(unsigned long msecs)
+{
+  QMutexLocker locker(&_stateMutex);
+  if (! _finished)
+    _finishedCondition.wait(&_stateMutex, msecs);
+  return _finished;
+}
+
+/* delete the task once execute() is done with it. this is the only safe
+   way to get rid of a task that has been started.
+ */
+void XSqlPoolTask::deleteWhenFinished()
+{
+  QMutexLocker locker(&_stateMutex);
+  if (_finished)
+    deleteLater();
+  else
+    _deleteWhenFinished = true;
+}
+
+/* run the task and tell everyone waiting for it. finished() is emitted
+   before the task is marked finished, so whoever sees isFinished() knows
+   the signal has already gone out. deleteWhenFinished() decides under
+   the same lock whether it or this thread queues the delete.
+ */
+void XSqlPoolTask::execute(QSqlDatabase &db)
+{
+  run(db);
+  emit finished();
+
+  bool deleteNow;
+  {
+    QMutexLocker locker(&_stateMutex);
+    _finished = true;
+    _finishedCondition.wakeAll();
+    deleteNow = _deleteWhenFinished;
+  }
+  if (deleteNow)
+    deleteLater();
+}
+
+XSqlConnectionPool *XSqlConnectionPool::_instance = 0;
+
+XSqlConnectionPool *XSqlConnectionPool::instance()
+{
+  if (! _instance)
+  {
+    _instance = new XSqlConnectionPool(qApp);
+    if (qApp)
+      connect(qApp, SIGNAL(aboutToQuit()), _instance, SLOT(stop()));
+  }
+  return _instance;
+}
+
+XSqlConnectionPool::XSqlConnectionPool(QObject *parent)
+  : QObject(parent),
+    _port(-1),
+    _idle(0),
+    _lastSerial(0),
+    _stopped(false),
+    _fallBack(false)
+{
+  setObjectName("XSqlConnectionPool");
+  _maxConnections = 1;
+
+  // copy the credentials login2 used, while we're still on the GUI thread
+  QSqlDatabase db = QSqlDatabase::database();
+  _driver   = db.driverName();
+  _database = db.databaseName();
+  _host     = db.hostName();
+  _port     = db.port();
+  _user     = db.userName();
+  _password = db.password();
+  _options  = db.connectOptions();
+
+  if (db.isOpen())
+  {
+    QSqlQuery pathq(db);
+    pathq.exec("SELECT current_setting('search_path') AS path;");
+    if (pathq.first())
+      _searchPath = pathq.value("path").toString();
+  }
+}
+
+XSqlConnectionPool::~XSqlConnectionPool()
+{
+  stop();
+  if (_instance == this)
+    _instance = 0;
+}
+
+bool XSqlConnectionPool::canRunThreaded()
+{
+  QSqlDatabase db = QSqlDatabase::database();
+  return db.isValid() && db.isOpen() && QThread::idealThreadCount() > 1;
+}
+
+/* copy the rows of an executed query. each row is a QVariantList in the
+   same order as columns.
+ */
+void XSqlConnectionPool::read(QSqlQuery &query, QStringList &columns, QVariantList &rows)
+{
+  columns.clear();
+  rows.clear();
+
+  QSqlRecord record = query.record();
+  for (int i = 0; i < record.count(); i++)
+    columns.append(record.fieldName(i));
+
+  while (query.next())
+  {
+    QVariantList row;
+    for (int i = 0; i < columns.size(); i++)
+      row.append(query.value(i));
+    rows.append(QVariant(row));
+  }
+}
+
+int XSqlConnectionPool::maxConnections() const
+{
+  return _maxConnections;
+}
+
+void XSqlConnectionPool::setMaxConnections(int max)
+{
+  QMutexLocker locker(&_mutex);
+  _maxConnections = qMax(1, max);
+}
+
+/* queue task for the next free pool thread, starting another thread if
+   all of them are busy and there is still room in the pool.
+ */
+void XSqlConnectionPool::start(XSqlPoolTask *task)
+{
+  if (! task)
+    return;
+
+  QMutexLocker locker(&_mutex);
+  if (_stopped)
+  {
+    locker.unlock();
+    QSqlDatabase closed;
+    task->execute(closed);
+    return;
+  }
+  else if (_fallBack)
+  {
+    locker.unlock();
+    QSqlDatabase db = QSqlDatabase::database();
+    task->execute(db);
+    return;
+  }
+
+  _pending.append(task);
+  if (_idle < _pending.size() && _workers.size() < _maxConnections)
+  {
+    XSqlConnectionPoolWorker *worker =
+                          new XSqlConnectionPoolWorker(this, _workers.size());
+    _workers.append(worker);
+    worker->start();
+    if (DEBUG)
+      qDebug("XSqlConnectionPool::start() started connection %d",
+             _workers.size());
+  }
+  _wake.wakeOne();
+}
+
+/* run sql on a pooled connection. the result arrives with queryFinished()
+   carrying the returned serial number.
+ */
+qulonglong XSqlConnectionPool::exec(const QString &sql, const QVariantMap &bindings)
+{
+  qulonglong serial;
+  {
+    QMutexLocker locker(&_mutex);
+    serial = ++_lastSerial;
+  }
+
+  XSqlPoolQueryTask *task = new XSqlPoolQueryTask(serial, sql, bindings);
+  task->deleteWhenFinished();
+  start(task);
+  return serial;
+}
+
+/* drop the exec() with the given serial if it has not started yet */
+bool XSqlConnectionPool::cancel(qulonglong serial)
+{
+  QMutexLocker locker(&_mutex);
+  for (int i = 0; i < _pending.size(); i++)
+  {
+    XSqlPoolQueryTask *task = dynamic_cast<XSqlPoolQueryTask*>(_pending.at(i));
+    if (task && task->serial() == serial)
+    {
+      _pending.removeAt(i);
+      task->deleteLater();
+      return true;
+    }
+  }
+  return false;
+}
+
+/* cancel the running queries, stop the threads, and finish whatever
+   is still queued without a connection so nobody waits forever. a thread
+   that still doesn't stop within STOPWAIT is abandoned rather than
+   holding up the shutdown.
+ */
+void XSqlConnectionPool::stop()
+{
+  QList<XSqlConnectionPoolWorker*> workers;
+  QList<XSqlPoolTask*>             pending;
+  QList<int>                       pids;
+  {
+    QMutexLocker locker(&_mutex);
+    _stopped = true;
+    workers  = _workers;
+    pending  = _pending;
+    _workers.clear();
+    _pending.clear();
+    foreach (XSqlConnectionPoolWorker *worker, workers)
+      if (worker->isRunning() && worker->backendPid() > 0)
+        pids.append(worker->backendPid());
+    _wake.wakeAll();
+  }
+
+  QSqlDatabase maindb = QSqlDatabase::database(QSqlDatabase::defaultConnection, false);
+  if (maindb.isOpen())
+  {
+    QSqlQuery cancelq(maindb);
+    cancelq.prepare("SELECT pg_cancel_backend(:pid);");
+    foreach (int pid, pids)
+    {
+      cancelq.bindValue(":pid", pid);
+      cancelq.exec();
+    }
+  }
+
+  foreach (XSqlConnectionPoolWorker *worker, workers)
+  {
+    if (worker->wait(STOPWAIT))
+      delete worker;
+    else
+      qWarning("XSqlConnectionPool::stop() gave up waiting for a connection");
+  }
+
+  QSqlDatabase closed;
+  foreach (XSqlPoolTask *task, pending)
+    task->execute(closed);
+}
+
+// called by the pool threads. returns 0 when the thread should quit
+XSqlPoolTask *XSqlConnectionPool::next()
+{
+  QMutexLocker locker(&_mutex);
+  _idle++;
+  while (_pending.isEmpty() && ! _stopped && ! _fallBack)
+    _wake.wait(&_mutex);
+  _idle--;
+
+  if (_stopped || _fallBack)
+    return 0;
+  return _pending.takeFirst();
+}
+
+// called by the pool threads. sets backendPid for stop() to cancel
+bool XSqlConnectionPool::openConnection(QSqlDatabase &db, int &backendPid)
+{
+  db.setDatabaseName(_database);
+  db.setHostName(_host);
+  db.setPort(_port);
+  db.setUserName(_user);
+  db.setPassword(_password);
+  db.setConnectOptions(_options);
+  if (! db.open())
+  {
+    qWarning("XSqlConnectionPool could not connect: %s",
+             qPrintable(db.lastError().text()));
+    return false;
+  }
+
+  /* the pooled sessions only read, so they skip the rest of the login
+     and just resolve names the way the default connection does
+   */
+  QSqlQuery setupq(db);
+  if (_searchPath.isEmpty())
+    setupq.prepare("SELECT pg_backend_pid() AS pid;");
+  else
+  {
+    setupq.prepare("SELECT set_config('search_path', :path, false),"
+                   "       pg_backend_pid() AS pid;");
+    setupq.bindValue(":path", _searchPath);
+  }
+  setupq.exec();
+  if (! setupq.first())
+  {
+    qWarning("XSqlConnectionPool could not set up the connection: %s",
+             qPrintable(setupq.lastError().text()));
+    db.close();
+    return false;
+  }
+
+  backendPid = setupq.value("pid").toInt();
+  return true;
+}
+
+/* called by a pool thread that could not set up its connection. the
+   other pool connections would fail the same way, so stop the threads
+   and run this task and everything after it on the default connection.
+ */
+void XSqlConnectionPool::fallBack(XSqlPoolTask *task)
+{
+  QMutexLocker locker(&_mutex);
+  if (_stopped)
+  {
+    locker.unlock();
+    QSqlDatabase closed;
+    task->execute(closed);
+    return;
+  }
+
+  _fallBack = true;
+  _pending.prepend(task);
+  _wake.wakeAll();
+  QMetaObject::invokeMethod(this, "sRunPending", Qt::QueuedConnection);
+}
+
+// runs on the GUI thread after fallBack()
+void XSqlConnectionPool::sRunPending()
+{
+  QList<XSqlPoolTask*> pending;
+  {
+    QMutexLocker locker(&_mutex);
+    pending = _pending;
+    _pending.clear();
+  }
+
+  QSqlDatabase db = QSqlDatabase::database();
+  foreach (XSqlPoolTask *task, pending)
+    task->execute(db);
+}
@@ -0,0 +1,149 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#ifndef __XSQLCONNECTIONPOOL_H__
+#define __XSQLCONNECTIONPOOL_H__
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QSqlDatabase>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVariant>
+#include <QVariantMap>
+#include <QWaitCondition>
+
+class QSqlQuery;
+class XSqlConnectionPool;
+class XSqlConnectionPoolWorker;
+class XSqlPoolQueryTask;
+
+/* One piece of read-only database work for the XSqlConnectionPool.
+   Subclasses implement run(), which is called on a pool thread with that
+   thread's connection already open and using the default connection's
+   search_path. If the pool cannot connect, run() is called on the GUI
+   thread with the default connection instead. The task object itself
+   lives on the thread that created it and gets finished() there.
+
+   A started task may still be inside execute() on its pool thread after
+   the owner has lost interest, so never delete one directly; call
+   deleteWhenFinished() instead.
+
+   Pooled connections are separate sessions: they cannot see uncommitted
+   changes made on the default connection, so only use them for reads.
+ */
+class XSqlPoolTask : public QObject
+{
+  Q_OBJECT
+
+  friend class XSqlConnectionPool;
+  friend class XSqlConnectionPoolWorker;
+
+  public:
+    XSqlPoolTask(QObject *parent = 0);
+    virtual ~XSqlPoolTask();
+
+    void start();
+    bool isFinished() const;
+    bool wait(unsigned long msecs = ULONG_MAX);
+    void deleteWhenFinished();
+
+  signals:
+    void finished();
+
+  protected:
+    // db is not open if the pool could not connect or is shutting down
+    virtual void run(QSqlDatabase &db) = 0;
+
+  private:
+    void execute(QSqlDatabase &db);
+
+    mutable QMutex _stateMutex;
+    QWaitCondition _finishedCondition;
+    bool           _finished;
+    bool           _deleteWhenFinished;
+};
+
+/* Extra authenticated connections beside the default one, each owned by
+   its own thread, so slow read-only queries don't freeze the GUI.
+   Threads and their connections are created on demand, up to
+   maxConnections(), and then kept for the rest of the session.
+
+   Every pooled connection is one more database session per client, which
+   counts against the server's max_connections. The pool therefore uses
+   a single connection unless the PooledConnections metric asks for more.
+
+   exec() is the simple case: it queues a query and queryFinished()
+   delivers the rows on the GUI thread. start() runs any XSqlPoolTask.
+ */
+class XSqlConnectionPool : public QObject
+{
+  Q_OBJECT
+
+  friend class XSqlConnectionPoolWorker;
+  friend class XSqlPoolQueryTask;
+
+  public:
+    static XSqlConnectionPool *instance();
+    static bool canRunThreaded();
+    static void read(QSqlQuery &query, QStringList &columns, QVariantList &rows);
+
+    int        maxConnections() const;
+    void       setMaxConnections(int max);
+
+    void       start(XSqlPoolTask *task);
+    qulonglong exec(const QString &sql,
+                    const QVariantMap &bindings = QVariantMap());
+    bool       cancel(qulonglong serial);
+
+  public slots:
+    void stop();
+
+  private slots:
+    void sRunPending();
+
+  signals:
+    void queryFinished(qulonglong serial, const QStringList &columns,
+                       const QVariantList &rows, const QString &error);
+
+  private:
+    XSqlConnectionPool(QObject *parent = 0);
+    ~XSqlConnectionPool();
+
+    XSqlPoolTask *next();
+    bool          openConnection(QSqlDatabase &db, int &backendPid);
+    void          fallBack(XSqlPoolTask *task);
+
+    static XSqlConnectionPool *_instance;
+
+    QString _driver;
+    QString _database;
+    QString _host;
+    int     _port;
+    QString _user;
+    QString _password;
+    QString _options;
+    QString _searchPath;
+
+    // shared with the pool threads, guarded by _mutex
+    QMutex                           _mutex;
+    QWaitCondition                   _wake;
+    QList<XSqlPoolTask*>             _pending;
+    QList<XSqlConnectionPoolWorker*> _workers;
+    int                              _idle;
+    int                              _maxConnections;
+    qulonglong                       _lastSerial;
+    bool                             _stopped;
+    bool                             _fallBack;
+};
+
+#endif
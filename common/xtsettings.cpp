@@ -10,32 +10,191 @@
 
 #include "xtsettings.h"
 
+#include <QBasicTimer>
+#include <QCoreApplication>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
 #include <QSettings>
+#include <QThread>
+#include <QTimerEvent>
 
-QVariant xtsettingsValue(const QString & key, const QVariant & defaultValue)
+#define DEBUG false
+
+// how long to collect changes before writing them out
+#define FLUSHDELAY 2000
+
+/* Process-wide copy of the user's settings. Both settings files are read
+   once, reads are served from memory, and changes are written together
+   shortly after they are made and again when the application exits.
+ */
+class XtSettingsCache : public QObject
 {
-  QSettings settings(QSettings::UserScope, "xTuple.com", "xTuple");
-  QString key2 = key;
-  if(key.startsWith("/xTuple/"))
-    key2 = key2.replace(0, 8, QString("/OpenMFG/"));
-  if(settings.contains(key))
-    return settings.value(key, defaultValue);
-  else
+  public:
+    static XtSettingsCache *instance();
+    static void             flushAll();
+
+    QVariant value(const QString &key, const QVariant &defaultValue);
+    void     setValue(const QString &key, const QVariant &value);
+    void     flush();
+
+  protected:
+    virtual void timerEvent(QTimerEvent *event);
+
+  private:
+    XtSettingsCache();
+    ~XtSettingsCache();
+
+    static QString normalize(const QString &key);
+    void           loadLegacy();
+
+    static XtSettingsCache *_instance;
+
+    QMutex                   _mutex;
+    QBasicTimer              _timer;
+    QHash<QString, QVariant> _values;
+    QHash<QString, QVariant> _legacy;
+    QSet<QString>            _dirty;
+    bool                     _legacyLoaded;
+};
+
+XtSettingsCache *XtSettingsCache::_instance = 0;
+
+XtSettingsCache *XtSettingsCache::instance()
+{
+  if (! _instance)
   {
-    QSettings oldsettings(QSettings::UserScope, "OpenMFG.com", "OpenMFG");
-    if(oldsettings.contains(key2))
+    _instance = new XtSettingsCache();
+    if (QCoreApplication::instance())
     {
-      QVariant val = oldsettings.value(key2, defaultValue);
-      xtsettingsSetValue(key, val);
-      return val;
+      _instance->setParent(QCoreApplication::instance());
+      qAddPostRoutine(flushAll);
     }
   }
-  return defaultValue;
+  return _instance;
 }
 
-void xtsettingsSetValue(const QString & key, const QVariant & value)
+void XtSettingsCache::flushAll()
+{
+  if (_instance)
+    _instance->flush();
+}
+
+XtSettingsCache::XtSettingsCache()
+  : _legacyLoaded(false)
+{
+  QSettings settings(QSettings::UserScope, "xTuple.com", "xTuple");
+  foreach (QString key, settings.allKeys())
+    _values.insert(key, settings.value(key));
+
+  if (DEBUG)
+    qDebug("XtSettingsCache loaded %d settings", _values.size());
+}
+
+XtSettingsCache::~XtSettingsCache()
+{
+  flush();
+  if (_instance == this)
+    _instance = 0;
+}
+
+// QSettings ignores leading, trailing, and repeated slashes
+QString XtSettingsCache::normalize(const QString &key)
+{
+  return key.split('/', QString::SkipEmptyParts).join("/");
+}
+
+// the OpenMFG file only matters for keys that were never saved under xTuple
+void XtSettingsCache::loadLegacy()
+{
+  if (_legacyLoaded)
+    return;
+  _legacyLoaded = true;
+
+  QSettings oldsettings(QSettings::UserScope, "OpenMFG.com", "OpenMFG");
+  foreach (QString key, oldsettings.allKeys())
+    _legacy.insert(key, oldsettings.value(key));
+}
+
+QVariant XtSettingsCache::value(const QString &key, const QVariant &defaultValue)
+{
+  QMutexLocker locker(&_mutex);
+
+  QString name = normalize(key);
+  QHash<QString, QVariant>::const_iterator it = _values.constFind(name);
+  if (it != _values.constEnd())
+    return it.value();
+
+  QString name2 = name;
+  if (key.startsWith("/xTuple/"))
+    name2 = name2.replace(0, 6, QString("OpenMFG"));
+
+  loadLegacy();
+  it = _legacy.constFind(name2);
+  if (it == _legacy.constEnd())
+    return defaultValue;
+
+  QVariant val = it.value();
+  locker.unlock();
+  setValue(key, val);
+  return val;
+}
+
+void XtSettingsCache::setValue(const QString &key, const QVariant &value)
 {
+  QString name = normalize(key);
+  {
+    QMutexLocker locker(&_mutex);
+    _values.insert(name, value);
+    _dirty.insert(name);
+  }
+
+  if (! parent())
+    flush(); // no event loop to write it later
+  else if (QThread::currentThread() == thread() && ! _timer.isActive())
+    _timer.start(FLUSHDELAY, this);
+}
+
+void XtSettingsCache::flush()
+{
+  QMutexLocker locker(&_mutex);
+  if (_dirty.isEmpty())
+    return;
+
   QSettings settings(QSettings::UserScope, "xTuple.com", "xTuple");
-  settings.setValue(key, value);
+  foreach (QString name, _dirty)
+    settings.setValue(name, _values.value(name));
+  settings.sync();
+
+  if (DEBUG)
+    qDebug("XtSettingsCache::flush() wrote %d settings", _dirty.size());
+  _dirty.clear();
 }
 
+void XtSettingsCache::timerEvent(QTimerEvent *event)
+{
+  if (event->timerId() != _timer.timerId())
+  {
+    QObject::timerEvent(event);
+    return;
+  }
+
+  _timer.stop();
+  flush();
+}
+
+QVariant xtsettingsValue(const QString & key, const QVariant & defaultValue)
+{
+  return XtSettingsCache::instance()->value(key, defaultValue);
+}
+
+void xtsettingsSetValue(const QString & key, const QVariant & value)
+{
+  XtSettingsCache::instance()->setValue(key, value);
+}
+
+void xtsettingsFlush()
+{
+  XtSettingsCache::flushAll();
+}
@@ -47,7 +47,7 @@ contracts::contracts(QWidget* parent, const char*, Qt::WindowFlags fl)
   list()->addColumn(tr("Expires"),            _dateColumn, Qt::AlignLeft,   true,  "contrct_expires"   );
   list()->addColumn(tr("Item Count"),         _itemColumn, Qt::AlignLeft,   true,  "item_count"   );
 
-  connect(omfgThis, SIGNAL(contractsUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(contractsUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 
   if (_privileges->check("MaintainItemSources"))
     connect(list(), SIGNAL(itemSelected(int)), this, SLOT(sEdit()));
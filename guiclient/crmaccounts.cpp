@@ -70,14 +70,14 @@ crmaccounts::crmaccounts(QWidget* parent, const char*, Qt::WindowFlags fl)
   parameterWidget()->append(tr("Country Pattern"), "addr_country_pattern", ParameterWidget::Text);
   parameterWidget()->applyDefaultFilterSet();
 
-  connect(omfgThis, SIGNAL(crmAccountsUpdated(int)),     this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(customersUpdated(int, bool)), this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(employeeUpdated(int)),        this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(prospectsUpdated()),          this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(salesRepUpdated(int)),        this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(taxAuthsUpdated(int)),        this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(userUpdated(QString)),        this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(vendorsUpdated()),            this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(crmAccountsUpdated(int)),     this, SLOT(sScheduleFillList(int)));
+  connect(omfgThis, SIGNAL(customersUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
+  connect(omfgThis, SIGNAL(employeeUpdated(int)),        this, SLOT(sScheduleFillList(int)));
+  connect(omfgThis, SIGNAL(prospectsUpdated()),          this, SLOT(sScheduleFillList()));
+  connect(omfgThis, SIGNAL(salesRepUpdated(int)),        this, SLOT(sScheduleFillList(int)));
+  connect(omfgThis, SIGNAL(taxAuthsUpdated(int)),        this, SLOT(sScheduleFillList(int)));
+  connect(omfgThis, SIGNAL(userUpdated(QString)),        this, SLOT(sScheduleFillList()));
+  connect(omfgThis, SIGNAL(vendorsUpdated()),            this, SLOT(sScheduleFillList()));
 
   list()->addColumn(tr("Number"),         80, Qt::AlignLeft,    true, "crmacct_number");
   list()->addColumn(tr("Active"),  _ynColumn,  Qt::AlignCenter,false, "crmacct_active");
@@ -10,14 +10,18 @@
 
 #include "characteristic.h"
 #include "display.h"
+#include "metasqlcache.h"
+#include "reportcache.h"
 #include "xlineedit.h"
 #include "ui_display.h"
 
+#include <QSqlDatabase>
 #include <QSqlError>
 #include <QMessageBox>
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QShortcut>
+#include <QTimer>
 #include <QToolButton>
 
 #include <metasql.h>
@@ -30,6 +34,9 @@
 
 #include "../scriptapi/parameterlistsetup.h"
 
+// how long to collect update signals before refreshing the list
+#define FILLLISTDELAY 500
+
 class displayPrivate : public Ui::display
 {
 public:
@@ -45,6 +52,8 @@ public:
     _useAltId = false;
     _queryOnStartEnabled = false;
     _autoUpdateEnabled = false;
+    _fillListPending = false;
+    _fillListDeferred = false;
 
     // Build Toolbar even if we hide it so we get actions
     _newBtn = new QToolButton(_toolBar);
@@ -134,6 +143,8 @@ public:
   bool _useAltId;
   bool _queryOnStartEnabled;
   bool _autoUpdateEnabled;
+  bool _fillListPending;
+  bool _fillListDeferred;
 
   QAction* _newAct;
   QAction* _closeAct;
@@ -151,6 +162,7 @@ public:
   QAction* _autoUpdateAct;
 
   QMenu* _queryMenu;
+  QTimer* _fillListTimer;
 
   QToolButton * _newBtn;
   QToolButton * _closeBtn;
@@ -179,27 +191,18 @@ void displayPrivate::print(ParameterList pParams, bool showPreview, bool forceSe
   }
   params.append("isReport", true);
 
-  XSqlQuery report;
-  report.prepare("SELECT report_grade, report_source "
-                 "  FROM report "
-                 " WHERE (report_name=:report_name)"
-                 " ORDER BY report_grade DESC LIMIT 1");
-  report.bindValue(":report_name", reportName);
-  report.exec();
-  QDomDocument _doc;
-  if (report.first())
+  QString errorMessage;
+  int     errorLine = 0;
+  QDomDocument _doc = ReportCache::instance()->definition(reportName, -1,
+                                                         &errorMessage,
+                                                         &errorLine);
+  if (_doc.isNull() && ! errorMessage.isEmpty())
   {
-    QString errorMessage;
-    int     errorLine;
-
-    if (!_doc.setContent(report.value("report_source").toString(), &errorMessage, &errorLine))
-    {
-      QMessageBox::critical(_parent, ::display::tr("Error Parsing Report"),
-        ::display::tr("There was an error Parsing the report definition. %1 %2").arg(errorMessage).arg(errorLine));
-      return;
-    }
+    QMessageBox::critical(_parent, ::display::tr("Error Parsing Report"),
+      ::display::tr("There was an error Parsing the report definition. %1 %2").arg(errorMessage).arg(errorLine));
+    return;
   }
-  else
+  else if (_doc.isNull())
   {
     QMessageBox::critical(_parent, ::display::tr("Report Not Found"),
       ::display::tr("The report %1 does not exist.").arg(reportName));
@@ -408,8 +411,14 @@ display::display(QWidget* parent, const char* name, Qt::WindowFlags flags)
   connect(_data->_searchAct, SIGNAL(triggered()), this, SLOT(sFillList()));
   connect(this, SIGNAL(fillList()), this, SLOT(sFillList()));
   connect(_data->_list, SIGNAL(populateMenu(QMenu*,QTreeWidgetItem*,int)), this, SLOT(sPopulateMenu(QMenu*,QTreeWidgetItem*,int)));
+  connect(_data->_list, SIGNAL(populated()), this, SLOT(sListPopulated()));
   connect(_data->_autoupdate, SIGNAL(toggled(bool)), this, SLOT(sAutoUpdateToggled()));
   connect(filterButton, SIGNAL(toggled(bool)), _data->_moreBtn, SLOT(setChecked(bool)));
+
+  _data->_fillListTimer = new QTimer(this);
+  _data->_fillListTimer->setSingleShot(true);
+  _data->_fillListTimer->setInterval(FILLLISTDELAY);
+  connect(_data->_fillListTimer, SIGNAL(timeout()), this, SLOT(sRunScheduledFillList()));
 }
 
 display::~display()
@@ -429,7 +438,12 @@ void display::showEvent(QShowEvent * e)
 
   if (_data->_queryOnStartEnabled &&
       _data->_queryonstart->isChecked())
+  {
+    _data->_fillListDeferred = false;
     emit fillList();
+  }
+  else if (_data->_fillListDeferred)
+    sScheduleFillList();
 }
 
 QWidget * display::optionsWidget()
@@ -720,13 +734,21 @@ void display::sFillList(ParameterList pParams, bool forceSetParams)
   int itemid = _data->_list->id();
   bool ok = true;
   QString errorString;
-  MetaSQLQuery mql = MQLUtil::mqlLoad(_data->metasqlGroup, _data->metasqlName, errorString, &ok);
+  QSharedPointer<MetaSQLQuery> mql = MetaSQLCache::instance()->query(_data->metasqlGroup, _data->metasqlName, errorString, &ok);
   if(!ok)
   {
     systemError(this, errorString, __FILE__, __LINE__);
     return;
   }
-  XSqlQuery xq = mql.toQuery(pParams);
+  if (_data->_list->populateThreaded())
+  {
+    // the list runs the query itself, off the GUI thread
+    XSqlQuery xq = mql->toQuery(pParams, QSqlDatabase(), false);
+    _data->_fillListPending = true;
+    _data->_list->populate(xq.lastQuery(), xq.boundValues(), itemid, _data->_useAltId);
+    return;
+  }
+  XSqlQuery xq = mql->toQuery(pParams);
   _data->_list->populate(xq, itemid, _data->_useAltId);
   if (xq.lastError().type() != QSqlError::NoError)
   {
@@ -740,13 +762,70 @@ void display::sPopulateMenu(QMenu *, QTreeWidgetItem *, int)
 {
 }
 
+void display::sListPopulated()
+{
+  if (_data->_fillListPending)
+  {
+    _data->_fillListPending = false;
+    emit fillListAfter();
+  }
+}
+
 void display::sAutoUpdateToggled()
 {
   bool update = _data->_autoUpdateEnabled && _data->_autoupdate->isChecked();
   if (update)
-    connect(omfgThis, SIGNAL(tick()), this, SLOT(sFillList()));
+    connect(omfgThis, SIGNAL(tick()), this, SLOT(sScheduleFillList()));
   else
-    disconnect(omfgThis, SIGNAL(tick()), this, SLOT(sFillList()));
+    disconnect(omfgThis, SIGNAL(tick()), this, SLOT(sScheduleFillList()));
+}
+
+/* Connect update signals here instead of to sFillList() so a burst of
+   updates refreshes the list once and hidden windows wait until shown.
+ */
+void display::sScheduleFillList()
+{
+  if (! _data->_fillListTimer->isActive())
+    _data->_fillListTimer->start();
+}
+
+/* only ask wantsFillList() when this update could actually cause a
+   refresh: nothing is pending yet and the window is showing. hidden
+   windows just defer a full refresh.
+ */
+void display::sScheduleFillList(int id)
+{
+  QWidget *subwindow = parentWidget();
+  bool showing = isVisible() && ! isMinimized() &&
+                 ! (subwindow && subwindow->isMinimized());
+  if (id > 0 && showing &&
+      ! _data->_fillListTimer->isActive() && ! _data->_fillListDeferred &&
+      ! wantsFillList(id))
+    return;
+  sScheduleFillList();
+}
+
+/* Subclasses that show only some records override this to ignore
+   update signals for ids that cannot change what they display. it runs
+   for every update signal, so decide from what the last sFillList()
+   found instead of querying the database.
+ */
+bool display::wantsFillList(int)
+{
+  return true;
+}
+
+void display::sRunScheduledFillList()
+{
+  QWidget *subwindow = parentWidget();
+  if (! isVisible() || isMinimized() || (subwindow && subwindow->isMinimized()))
+  {
+    _data->_fillListDeferred = true;
+    return;
+  }
+
+  _data->_fillListDeferred = false;
+  sFillList();
 }
 
 ParameterList display::getParams()
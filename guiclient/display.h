@@ -84,14 +84,19 @@ public slots:
     virtual void sFillList();
     virtual void sFillList(ParameterList, bool = false);
     virtual void sPopulateMenu(QMenu *, QTreeWidgetItem *, int);
+    virtual void sScheduleFillList();
+    virtual void sScheduleFillList(int);
 
 protected:
     Q_INVOKABLE ParameterList getParams();
+    virtual bool wantsFillList(int);
     virtual void showEvent(QShowEvent*);
 
 protected slots:
     virtual void languageChange();
     virtual void sAutoUpdateToggled();
+    virtual void sListPopulated();
+    virtual void sRunScheduledFillList();
 
 signals:
     void fillList();
@@ -86,13 +86,13 @@ void dspInvalidBillsOfMaterials::sHandleUpdate()
 {
   if (_update->isChecked())
   {
-    connect(omfgThis, SIGNAL(itemsUpdated(int, bool)), this, SLOT(sFillList()));
-    connect(omfgThis, SIGNAL(itemsitesUpdated()), this, SLOT(sFillList()));
+    connect(omfgThis, SIGNAL(itemsUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
+    connect(omfgThis, SIGNAL(itemsitesUpdated()), this, SLOT(sScheduleFillList()));
   }
   else
   {
-    disconnect(omfgThis, SIGNAL(itemsUpdated(int, bool)), this, SLOT(sFillList()));
-    disconnect(omfgThis, SIGNAL(itemsitesUpdated()), this, SLOT(sFillList()));
+    disconnect(omfgThis, SIGNAL(itemsUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
+    disconnect(omfgThis, SIGNAL(itemsitesUpdated()), this, SLOT(sScheduleFillList()));
   }
 }
 
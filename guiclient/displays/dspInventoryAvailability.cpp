@@ -63,7 +63,7 @@ dspInventoryAvailability::dspInventoryAvailability(QWidget* parent, const char*,
   sByVendorChanged();
 
   connect(_showReorder, SIGNAL(toggled(bool)), this, SLOT(sHandleShowReorder(bool)));
-  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
   connect(_byVendor, SIGNAL(toggled(bool)), this, SLOT(sByVendorChanged()));
   connect(_asof, SIGNAL(currentIndexChanged(int)), this, SLOT(sAsofChanged(int)));
 }
@@ -67,7 +67,7 @@ dspInventoryAvailabilityBySalesOrder::dspInventoryAvailabilityBySalesOrder(QWidg
     if(_useReservationNetting->isChecked())
       sHandleReservationNetting(true);
   }
-  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 }
 
 void dspInventoryAvailabilityBySalesOrder::languageChange()
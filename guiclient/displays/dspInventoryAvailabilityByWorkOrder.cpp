@@ -55,7 +55,7 @@ dspInventoryAvailabilityByWorkOrder::dspInventoryAvailabilityByWorkOrder(QWidget
   list()->addColumn(tr("Type"),                   0, Qt::AlignLeft, false, "woinvav_type");
 
 
-  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 }
 
 void dspInventoryAvailabilityByWorkOrder::languageChange()
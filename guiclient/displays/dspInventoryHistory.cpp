@@ -99,6 +99,7 @@ dspInventoryHistory::dspInventoryHistory(QWidget* parent, const char* name, Qt::
   list()->addColumn(tr("Value Before"),         _qtyColumn, Qt::AlignRight, false, "invhist_value_before");
   list()->addColumn(tr("Value After"),          _qtyColumn, Qt::AlignRight, false, "invhist_value_after");
   list()->addColumn(tr("User"),               _orderColumn, Qt::AlignCenter,false, "invhist_user");
+  list()->setPopulateThreaded(true);
 }
 
 enum SetResponse dspInventoryHistory::set(const ParameterList &pParams)
@@ -29,7 +29,7 @@ dspItemsWithoutItemSources::dspItemsWithoutItemSources(QWidget* parent, const ch
   list()->addColumn(tr("Description"), -1,           Qt::AlignLeft, true, "descrip");
   list()->addColumn(tr("Type"),        _itemColumn,  Qt::AlignCenter,true, "type");
 
-  connect(omfgThis, SIGNAL(itemsUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(itemsUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 }
 
 void dspItemsWithoutItemSources::sPopulateMenu(QMenu *pMenu, QTreeWidgetItem *, int)
@@ -51,7 +51,7 @@ dspPurchaseReqsByItem::dspPurchaseReqsByItem(QWidget* parent, const char*, Qt::W
   else
     newAction()->setEnabled(false);
   
-  connect(omfgThis, SIGNAL(purchaseRequestsUpdated()), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(purchaseRequestsUpdated()), this, SLOT(sScheduleFillList()));
 }
 
 void dspPurchaseReqsByItem::languageChange()
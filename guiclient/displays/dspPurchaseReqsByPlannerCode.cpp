@@ -59,7 +59,7 @@ dspPurchaseReqsByPlannerCode::dspPurchaseReqsByPlannerCode(QWidget* parent, cons
   else
     newAction()->setEnabled(false);
   
-  connect(omfgThis, SIGNAL(purchaseRequestsUpdated()), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(purchaseRequestsUpdated()), this, SLOT(sScheduleFillList()));
 }
 
 void dspPurchaseReqsByPlannerCode::languageChange()
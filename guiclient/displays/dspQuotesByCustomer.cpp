@@ -38,7 +38,7 @@ dspQuotesByCustomer::dspQuotesByCustomer(QWidget* parent, const char*, Qt::Windo
   list()->addColumn(tr("Cust. P/O #"), 200,          Qt::AlignLeft,   true,  "quhead_custponumber"   );
   list()->addColumn(tr("Status"),     _statusColumn,  Qt::AlignCenter, true,  "quhead_status" );
 
-  connect(omfgThis, SIGNAL(salesOrdersUpdated(int, bool)), this, SLOT(sFillList())  );
+  connect(omfgThis, SIGNAL(salesOrdersUpdated(int, bool)), this, SLOT(sScheduleFillList(int))  );
 }
 
 void dspQuotesByCustomer::languageChange()
@@ -38,7 +38,7 @@ dspQuotesByItem::dspQuotesByItem(QWidget* parent, const char*, Qt::WindowFlags f
   list()->addColumn(tr("Status"),     _statusColumn,  Qt::AlignCenter, true,  "quhead_status" );
   list()->addColumn(tr("Quoted"),     _qtyColumn,     Qt::AlignRight,  true,  "quitem_qtyord"  );
 
-  connect(omfgThis, SIGNAL(salesOrdersUpdated(int, bool)), this, SLOT(sFillList())); 
+  connect(omfgThis, SIGNAL(salesOrdersUpdated(int, bool)), this, SLOT(sScheduleFillList(int))); 
 }
 
 void dspQuotesByItem::languageChange()
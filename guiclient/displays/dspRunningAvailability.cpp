@@ -35,6 +35,7 @@ dspRunningAvailability::dspRunningAvailability(QWidget* parent, const char*, Qt:
   setUseAltId(true);
 
   _ready = true;
+  _maxWoid = -1;
 
   connect(list(),       SIGNAL(populated()), this, SLOT(sHandleResort()));
   connect(list(),       SIGNAL(resorted()), this, SLOT(sHandleResort()));
@@ -57,7 +58,7 @@ dspRunningAvailability::dspRunningAvailability(QWidget* parent, const char*, Qt:
   _orderMultiple->setValidator(omfgThis->qtyVal());
   _orderToQty->setValidator(omfgThis->qtyVal());
 
-  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(workOrdersUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 
   if (!_metrics->boolean("MultiWhs"))
   {
@@ -357,7 +358,8 @@ void dspRunningAvailability::sFillList()
                "       qtyNetable(itemsite_id) AS netableqoh,"
                "       CASE WHEN(itemsite_useparams) THEN itemsite_reorderlevel ELSE 0.0 END AS reorderlevel,"
                "       CASE WHEN(itemsite_useparams) THEN itemsite_ordertoqty   ELSE 0.0 END AS ordertoqty,"
-               "       CASE WHEN(itemsite_useparams) THEN itemsite_multordqty   ELSE 0.0 END AS multorderqty "
+               "       CASE WHEN(itemsite_useparams) THEN itemsite_multordqty   ELSE 0.0 END AS multorderqty,"
+               "       (SELECT COALESCE(MAX(wo_id), 0) FROM wo) AS maxwoid "
                "FROM item, itemsite "
                "WHERE ( (itemsite_item_id=item_id)"
                " AND (itemsite_warehous_id=:warehous_id)"
@@ -373,6 +375,28 @@ void dspRunningAvailability::sFillList()
       _orderMultiple->setDouble(dspFillList.value("multorderqty").toDouble());
       _orderToQty->setDouble(dspFillList.value("ordertoqty").toDouble());
 
+      XSqlQuery woq;
+      woq.prepare("SELECT wo_id"
+                  "  FROM wo JOIN itemsite ON (wo_itemsite_id=itemsite_id)"
+                  " WHERE ((itemsite_item_id=:item_id)"
+                  "   AND  (itemsite_warehous_id=:warehous_id))"
+                  " UNION "
+                  "SELECT womatl_wo_id"
+                  "  FROM womatl JOIN itemsite ON (womatl_itemsite_id=itemsite_id)"
+                  " WHERE ((itemsite_item_id=:item_id)"
+                  "   AND  (itemsite_warehous_id=:warehous_id));");
+      woq.bindValue(":item_id", _item->id());
+      woq.bindValue(":warehous_id", _warehouse->id());
+      woq.exec();
+      _woids.clear();
+      while (woq.next())
+        _woids.insert(woq.value("wo_id").toInt());
+      // refresh on every update if we can't tell which ones matter
+      if (woq.lastError().type() == QSqlError::NoError)
+        _maxWoid = dspFillList.value("maxwoid").toInt();
+      else
+        _maxWoid = -1;
+
       display::sFillList();
     }
     else if (dspFillList.lastError().type() != QSqlError::NoError)
@@ -383,6 +407,19 @@ void dspRunningAvailability::sFillList()
   }
 }
 
+/* only work orders that make or consume this item change the running totals.
+   decide from the work orders sFillList() found for the item and site so
+   no query runs per update. a work order newer than the last refresh may
+   be for this item, so it is wanted too.
+ */
+bool dspRunningAvailability::wantsFillList(int pWoid)
+{
+  if (!_item->isValid())
+    return false;
+
+  return _maxWoid < 0 || pWoid > _maxWoid || _woids.contains(pWoid);
+}
+
 void dspRunningAvailability::sDspWoScheduleByWorkOrder()
 {
   ParameterList params;
@@ -11,6 +11,8 @@
 #ifndef DSPRUNNINGAVAILABILITY_H
 #define DSPRUNNINGAVAILABILITY_H
 
+#include <QSet>
+
 #include "guiclient.h"
 #include "display.h"
 
@@ -44,11 +46,16 @@ public slots:
     virtual void sEditPo();
     virtual void sFillList();
 
+protected:
+    virtual bool wantsFillList(int pWoid);
+
 protected slots:
     virtual void languageChange();
 
 private:
-    bool _ready;
+    bool      _ready;
+    QSet<int> _woids;   // work orders for this item and site at the last refresh
+    int       _maxWoid; // newest work order at the last refresh, -1 if unknown
 
 };
 
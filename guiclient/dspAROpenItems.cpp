@@ -95,8 +95,8 @@ dspAROpenItems::dspAROpenItems(QWidget* parent, const char*, Qt::WindowFlags fl)
   list()->addColumn(tr("Credit Card"),            -1, Qt::AlignLeft,   false, "ccard_number");
   list()->addColumn(tr("Notes"),                  -1, Qt::AlignLeft,   false, "notes");
   
-  connect(omfgThis, SIGNAL(creditMemosUpdated()), this, SLOT(sFillList()));
-  connect(omfgThis, SIGNAL(invoicesUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(creditMemosUpdated()), this, SLOT(sScheduleFillList()));
+  connect(omfgThis, SIGNAL(invoicesUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 
   if (omfgThis->singleCurrency())
   {
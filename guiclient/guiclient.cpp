@@ -19,6 +19,8 @@
 #include <QToolBar>
 #include <QSqlDatabase>
 #include <QSqlDriver>
+#include <QSqlQuery>
+#include <QThread>
 #include <QImage>
 #include <QSplashScreen>
 #include <QMessageBox>
@@ -70,9 +72,12 @@
 
 #include "distributeInventory.h"
 #include "documents.h"
+#include "reportcache.h"
 #include "splashconst.h"
 #include "scripttoolbox.h"
 #include "menubutton.h"
+#include "xsqlconnectionpool.h"
+#include "xtextedit.h"
 
 #include "setup.h"
 #include "setupscriptapi.h"
@@ -86,6 +91,11 @@
 #endif
 #endif
 
+#define DEBUG false
+
+// words whose hunspell_check() result is remembered
+#define SPELLCACHESIZE 5000
+
 class Metrics;
 class Preferences;
 class Privileges;
@@ -151,6 +161,111 @@ static SaveSizePositionEventFilter * __saveSizePositionEventFilter = 0;
 static int __interval = 0;
 static int __intervalCount = 0;
 
+/* Read the date range and decode the workspace background image while the
+   GUIClient constructor builds the rest of the window. This runs on a
+   pooled connection, or the constructor calls load() directly.
+ */
+class GUIClientStartupTask : public XSqlPoolTask
+{
+  public:
+    GUIClientStartupTask(int imageId)
+      : _imageId(imageId),
+        _loaded(false),
+        _haveDates(false)
+    {
+    }
+
+    void load(QSqlDatabase &db)
+    {
+      _loaded = true;
+
+      QSqlQuery timeq(db);
+      timeq.exec("SELECT startOfTime() AS sot, endOfTime() AS eot;");
+      if (timeq.first())
+      {
+        _startOfTime = timeq.value(0).toDate();
+        _endOfTime   = timeq.value(1).toDate();
+        _haveDates   = true;
+      }
+
+      if (_imageId > 0)
+      {
+        QSqlQuery imageq(db);
+        imageq.prepare("SELECT image_data "
+                       "FROM image "
+                       "WHERE (image_id=:image_id);");
+        imageq.bindValue(":image_id", _imageId);
+        imageq.exec();
+        if (imageq.first())
+          _background.loadFromData(QUUDecode(imageq.value(0).toString()));
+      }
+    }
+
+    bool   loaded()      const { return _loaded;      }
+    bool   haveDates()   const { return _haveDates;   }
+    QDate  startOfTime() const { return _startOfTime; }
+    QDate  endOfTime()   const { return _endOfTime;   }
+    QImage background()  const { return _background; }
+
+  protected:
+    virtual void run(QSqlDatabase &db)
+    {
+      if (db.isOpen())
+        load(db);
+    }
+
+  private:
+    int    _imageId;
+    bool   _loaded;
+    bool   _haveDates;
+    QDate  _startOfTime;
+    QDate  _endOfTime;
+    QImage _background;
+};
+
+/* Build the Hunspell dictionary off the GUI thread. Large dictionaries
+   take long enough to load that they noticeably delay startup.
+ */
+class GUIClientHunspellLoader : public QThread
+{
+  public:
+    GUIClientHunspellLoader(const QString &path, const QString &userDic,
+                            QObject *parent)
+      : QThread(parent),
+        _checker(0),
+        _path(path),
+        _userDic(userDic)
+    {
+    }
+
+    ~GUIClientHunspellLoader()
+    {
+      wait();
+      delete _checker;
+    }
+
+    Hunspell *takeChecker()
+    {
+      Hunspell *result = _checker;
+      _checker = 0;
+      return result;
+    }
+
+  protected:
+    virtual void run()
+    {
+      _checker = new Hunspell(QString(_path + ".aff").toLatin1(),
+                              QString(_path + ".dic").toLatin1());
+      if (! _userDic.isEmpty())
+        _checker->add_dic(_userDic.toLatin1());
+    }
+
+  private:
+    Hunspell *_checker;
+    QString   _path;
+    QString   _userDic;
+};
+
 /** @brief Check if the current user has privileges to use the given Action.
     @sa    Action
   */
@@ -327,6 +442,7 @@ class xTupleGuiClientInterface : public GuiClientInterface
 
   QAction* findAction(const QString pname)
   {
+   omfgThis->completeMenuBar();
    return omfgThis->findChild<QAction*>(pname);
   }
 
@@ -388,10 +504,20 @@ GUIClient *omfgThis;
   */
 GUIClient::GUIClient(const QString &pDatabaseURL, const QString &pUsername)
 {
-  XSqlQuery _GGUIClient;
   _menuBar = 0;
   _activeWindow = 0;
   _shown = false;
+  _menuBuildStep = -1;
+  productsMenu    = 0;
+  inventoryMenu   = 0;
+  scheduleMenu    = 0;
+  purchaseMenu    = 0;
+  manufactureMenu = 0;
+  crmMenu         = 0;
+  salesMenu       = 0;
+  accountingMenu  = 0;
+  windowMenu      = 0;
+  systemMenu      = 0;
   _shuttingDown = false;
 
   _databaseURL = pDatabaseURL;
@@ -405,17 +531,11 @@ GUIClient::GUIClient(const QString &pDatabaseURL, const QString &pUsername)
   if(_preferences->value("InterfaceWindowOption") == "Workspace")
     _showTopLevel = false;
 
-  _GGUIClient.exec("SELECT startOfTime() AS sot, endOfTime() AS eot;");
-  if (_GGUIClient.first())
-  {
-    _startOfTime = _GGUIClient.value("sot").toDate();
-    _endOfTime = _GGUIClient.value("eot").toDate();
-  }
-  else
-    systemError( this, tr( "A Critical Error occurred at %1::%2.\n"
-                           "Please immediately log out and contact your Systems Adminitrator." )
-                       .arg(__FILE__)
-                       .arg(__LINE__) );
+  GUIClientStartupTask *startupTask =
+    new GUIClientStartupTask(_preferences->value("BackgroundImageid").toInt());
+  bool startupThreaded = XSqlConnectionPool::canRunThreaded();
+  if (startupThreaded)
+    startupTask->start();
 
   /*  TODO: either separate validators for extprice, purchprice, and salesprice
             or replace every field that uses _moneyVal, _negMoneyVal, _priceVal, and _costVal
@@ -492,21 +612,32 @@ GUIClient::GUIClient(const QString &pDatabaseURL, const QString &pUsername)
   _splash->showMessage(tr("Loading the Background Image"), SplashTextAlignment, SplashTextColor);
   qApp->processEvents();
 
-  if (_preferences->value("BackgroundImageid").toInt() > 0)
+  if (startupThreaded)
+    startupTask->wait();
+  if (! startupTask->loaded())
   {
-    _GGUIClient.prepare( "SELECT image_data "
-                "FROM image "
-                "WHERE (image_id=:image_id);" );
-    _GGUIClient.bindValue(":image_id", _preferences->value("BackgroundImageid").toInt());
-    _GGUIClient.exec();
-    if (_GGUIClient.first())
-    {
-      QImage background;
+    QSqlDatabase db = QSqlDatabase::database();
+    startupTask->load(db);
+  }
 
-      background.loadFromData(QUUDecode(_GGUIClient.value("image_data").toString()));
-      _workspace->setBackground(QBrush(QPixmap::fromImage(background)));
-    }
+  if (startupTask->haveDates())
+  {
+    _startOfTime = startupTask->startOfTime();
+    _endOfTime = startupTask->endOfTime();
   }
+  else
+    systemError( this, tr( "A Critical Error occurred at %1::%2.\n"
+                           "Please immediately log out and contact your Systems Adminitrator." )
+                       .arg(__FILE__)
+                       .arg(__LINE__) );
+
+  if (! startupTask->background().isNull())
+    _workspace->setBackground(QBrush(QPixmap::fromImage(startupTask->background())));
+
+  if (startupThreaded)
+    startupTask->deleteWhenFinished();
+  else
+    delete startupTask;
 
   _splash->showMessage(tr("Initializing Internal Timers"), SplashTextAlignment, SplashTextColor);
   qApp->processEvents();
@@ -586,6 +717,11 @@ GUIClient::GUIClient(const QString &pDatabaseURL, const QString &pUsername)
   _fileWatcher = new QFileSystemWatcher();
   connect(_fileWatcher, SIGNAL(fileChanged(QString)), this, SLOT(handleDocument(QString)));
 
+  _spellCodec = 0;
+  _spellChecker = 0;
+  _spellLoader = 0;
+  _spellReady = false;
+  _spellCache.setMaxCost(SPELLCACHESIZE);
   hunspell_initialize();
 
 }
@@ -696,6 +832,12 @@ void GUIClient::setCaption()
 
 /** @brief Build the application menus and toolbars based on
            the current user's preferences for menu and toolbar visibility.
+
+    The first call only prepares the menu bar. The module menus are built
+    one per pass through the event loop once the main window is visible,
+    so the window appears without waiting for about a thousand actions to
+    be created. Call completeMenuBar() before using a module menu, action,
+    or toolbar that may not exist yet.
  */
 void GUIClient::initMenuBar()
 {
@@ -705,6 +847,8 @@ void GUIClient::initMenuBar()
 
   if(!firstRun)
   {
+    completeMenuBar();
+
     QList<QMenu*> menulist = findChildren<QMenu*>();
     for(int m = 0; m < menulist.size(); ++m)
     {
@@ -712,6 +856,7 @@ void GUIClient::initMenuBar()
       for(int i = 0; i < actionlist.size(); ++i)
         __menuEvaluate(actionlist.at(i));
     }
+    setMenuBarVisibility();
   }
   else
   {
@@ -722,49 +867,71 @@ void GUIClient::initMenuBar()
     while(!toolbars.isEmpty())
       delete toolbars.takeFirst();
 
-    _splash->showMessage(tr("Initializing the Products Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    productsMenu = new menuProducts(this);
-
-    _splash->showMessage(tr("Initializing the Inventory Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    inventoryMenu = new menuInventory(this);
-
-    if(_metrics->value("Application") != "PostBooks")
-    {
-      _splash->showMessage(tr("Initializing the Scheduling Module"), SplashTextAlignment, SplashTextColor);
-      qApp->processEvents();
-      scheduleMenu = new menuSchedule(this);
-    }
-
-    _splash->showMessage(tr("Initializing the Purchase Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    purchaseMenu = new menuPurchase(this);
-
-    _splash->showMessage(tr("Initializing the Manufacture Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    manufactureMenu = new menuManufacture(this);
+    _menuBuildStep = 0;
+    if (isVisible())
+      QTimer::singleShot(0, this, SLOT(sBuildNextMenu()));
+  }
 
-    _splash->showMessage(tr("Initializing the CRM Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    crmMenu = new menuCRM(this);
+  firstRun = false;
+  qApp->restoreOverrideCursor();
+}
 
-    _splash->showMessage(tr("Initializing the Sales Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    salesMenu = new menuSales(this);
+/** @brief Build any module menus that initMenuBar() has not built yet.
 
-    _splash->showMessage(tr("Initializing the Accounting Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    accountingMenu = new menuAccounting(this);
+    This returns immediately if the menus are already complete.
+ */
+void GUIClient::completeMenuBar()
+{
+  if (_menuBuildStep < 0)
+    return;
 
-    windowMenu = new menuWindow(this);
+  qApp->setOverrideCursor(Qt::WaitCursor);
+  while (buildNextMenu())
+    ;
+  qApp->restoreOverrideCursor();
+}
 
-    _splash->showMessage(tr("Initializing the System Module"), SplashTextAlignment, SplashTextColor);
-    qApp->processEvents();
-    systemMenu = new menuSystem(this);
+void GUIClient::sBuildNextMenu()
+{
+  if (_menuBuildStep >= 0 && buildNextMenu())
+    QTimer::singleShot(0, this, SLOT(sBuildNextMenu()));
+}
 
+/* Build the next module menu in menu bar order. Returns false once they
+   have all been built and the menu bar has been finished.
+ */
+bool GUIClient::buildNextMenu()
+{
+  switch (_menuBuildStep++)
+  {
+    case 0: productsMenu    = new menuProducts(this);    break;
+    case 1: inventoryMenu   = new menuInventory(this);   break;
+    case 2:
+      if(_metrics->value("Application") != "PostBooks")
+        scheduleMenu = new menuSchedule(this);
+      break;
+    case 3: purchaseMenu    = new menuPurchase(this);    break;
+    case 4: manufactureMenu = new menuManufacture(this); break;
+    case 5: crmMenu         = new menuCRM(this);         break;
+    case 6: salesMenu       = new menuSales(this);       break;
+    case 7: accountingMenu  = new menuAccounting(this);  break;
+    case 8: windowMenu      = new menuWindow(this);      break;
+    case 9: systemMenu      = new menuSystem(this);      break;
+    default:
+      _menuBuildStep = -1;
+
+      setMenuBarVisibility();
+
+      if (_shown)
+        runInitMenuScripts();
+      return false;
   }
 
+  return true;
+}
+
+void GUIClient::setMenuBarVisibility()
+{
   findChild<QMenu*>("menu.prod")->menuAction()->setVisible(_preferences->boolean("ShowPDMenu"));
   findChild<QMenu*>("menu.im")->menuAction()->setVisible(_preferences->boolean("ShowIMMenu"));
   if(_metrics->value("Application") != "PostBooks")
@@ -792,9 +959,6 @@ void GUIClient::initMenuBar()
   findChild<QToolBar*>("CRM Tools")->setVisible(_preferences->boolean("ShowCRMToolbar"));
   findChild<QToolBar*>("Sales Tools")->setVisible(_preferences->boolean("ShowSOToolbar"));
   findChild<QToolBar*>("Accounting Tools")->setVisible(_preferences->boolean("ShowGLToolbar"));
-
-  firstRun = false;
-  qApp->restoreOverrideCursor();
 }
 
 /** @brief Save the position and visibility of application toolbars in
@@ -802,6 +966,8 @@ void GUIClient::initMenuBar()
   */
 void GUIClient::saveToolbarPositions()
 {
+  completeMenuBar();
+
   xtsettingsSetValue("MainWindowState", saveState(1));
 
   // Set preferences base on visibility of toolbars
@@ -878,80 +1044,92 @@ void GUIClient::closeEvent(QCloseEvent *event)
 
 /** @brief Perform extra application initialization.
 
-    Primarily this involves running application extension @c initMenu
-    scripts and setting up the script engine debugger if necessary.
+    The first time the main window is shown this starts building the
+    module menus that initMenuBar() deferred. The application extension
+    @c initMenu scripts run once the menus are complete.
   */
 void GUIClient::showEvent(QShowEvent *event)
 {
   if(!_shown)
   {
     _shown = true;
-    // We only want the scripting to work on the NEO menu
-    // START script code
-      XSqlQuery sq;
-      sq.prepare("SELECT script_source, script_order"
-              "  FROM script"
-              " WHERE((script_name=:script_name)"
-              "   AND (script_enabled))"
-              " ORDER BY script_order;");
-      sq.bindValue(":script_name", "initMenu");
-      sq.exec();
-      QScriptEngine * engine = 0;
-      QScriptEngineDebugger * debugger = 0;
-      bool found_one = false;
-      while(sq.next())
+    if (_menuBuildStep >= 0)
+      QTimer::singleShot(0, this, SLOT(sBuildNextMenu()));
+    else
+      runInitMenuScripts();
+  }
+
+  QMainWindow::showEvent(event);
+}
+
+/** @brief Run the application extension @c initMenu scripts, setting up
+           the script engine debugger if necessary.
+  */
+void GUIClient::runInitMenuScripts()
+{
+  // We only want the scripting to work on the NEO menu
+  // START script code
+    XSqlQuery sq;
+    sq.prepare("SELECT script_source, script_order"
+            "  FROM script"
+            " WHERE((script_name=:script_name)"
+            "   AND (script_enabled))"
+            " ORDER BY script_order;");
+    sq.bindValue(":script_name", "initMenu");
+    sq.exec();
+    QScriptEngine * engine = 0;
+    QScriptEngineDebugger * debugger = 0;
+    bool found_one = false;
+    while(sq.next())
+    {
+      found_one = true;
+      QString script = scriptHandleIncludes(sq.value("script_source").toString());
+      if(!engine)
       {
-        found_one = true;
-        QString script = scriptHandleIncludes(sq.value("script_source").toString());
-        if(!engine)
+        engine = new QScriptEngine(this);
+        if (_preferences->boolean("EnableScriptDebug"))
         {
-          engine = new QScriptEngine(this);
-          if (_preferences->boolean("EnableScriptDebug"))
-          {
-            debugger = new QScriptEngineDebugger(this);
-            debugger->attachTo(engine);
-          }
-          loadScriptGlobals(engine);
+          debugger = new QScriptEngineDebugger(this);
+          debugger->attachTo(engine);
         }
+        loadScriptGlobals(engine);
+      }
 
-        QScriptValue result = engine->evaluate(script, "initMenu");
-        if (engine->hasUncaughtException())
-        {
-          int line = engine->uncaughtExceptionLineNumber();
-          qDebug() << "uncaught exception at line" << line << ":" << result.toString();
-        }
+      QScriptValue result = engine->evaluate(script, "initMenu");
+      if (engine->hasUncaughtException())
+      {
+        int line = engine->uncaughtExceptionLineNumber();
+        qDebug() << "uncaught exception at line" << line << ":" << result.toString();
       }
-      if(found_one)
+    }
+    if(found_one)
+    {
+      QList<QMenu*> menulist = findChildren<QMenu*>();
+      for(int m = 0; m < menulist.size(); ++m)
       {
-        QList<QMenu*> menulist = findChildren<QMenu*>();
-        for(int m = 0; m < menulist.size(); ++m)
+        QList<QAction*> actionlist = menulist.at(m)->actions();
+        for(int i = 0; i < actionlist.size(); ++i)
         {
-          QList<QAction*> actionlist = menulist.at(m)->actions();
-          for(int i = 0; i < actionlist.size(); ++i)
+          QAction* act = actionlist.at(i);
+          if(!act->objectName().isEmpty())
           {
-            QAction* act = actionlist.at(i);
-            if(!act->objectName().isEmpty())
+            QString hotkey;
+            hotkey = _preferences->parent(act->objectName());
+            if (!hotkey.isNull() && !_hotkeyList.contains(hotkey))
             {
-              QString hotkey;
-              hotkey = _preferences->parent(act->objectName());
-              if (!hotkey.isNull() && !_hotkeyList.contains(hotkey))
-              {
-                _hotkeyList << hotkey;
-                act->setShortcutContext(Qt::ApplicationShortcut);
-                if (hotkey.left(1) == "C")
-                  act->setShortcut(QString("Ctrl+%1").arg(hotkey.right(1)));
-
-                else if (hotkey.left(1) == "F")
-                  act->setShortcut(hotkey);
-              }
+              _hotkeyList << hotkey;
+              act->setShortcutContext(Qt::ApplicationShortcut);
+              if (hotkey.left(1) == "C")
+                act->setShortcut(QString("Ctrl+%1").arg(hotkey.right(1)));
+
+              else if (hotkey.left(1) == "F")
+                act->setShortcut(hotkey);
             }
           }
         }
       }
-    // END script code
-  }
-
-  QMainWindow::showEvent(event);
+    }
+  // END script code
 }
 
 /** @brief Write a message to the debugging log.
@@ -1019,6 +1197,7 @@ void GUIClient::sTick()
           statusBar()->setMinimumHeight(36);
           statusBar()->addWidget(_eventButton);
 
+          completeMenuBar();
           connect(_eventButton, SIGNAL(clicked()), systemMenu, SLOT(sEventManager()));
         }
       }
@@ -1095,6 +1274,7 @@ void GUIClient::sNewErrorMessage()
     statusBar()->setMinimumHeight(36);
     statusBar()->addWidget(_errorButton);
 
+    completeMenuBar();
     connect(_errorButton, SIGNAL(clicked()), systemMenu, SLOT(sErrorLog()));
   }
 }
@@ -1450,6 +1630,7 @@ void GUIClient::sQOHChanged(int pItemsiteid, bool pLocal)
   */
 void GUIClient::sReportsChanged(int pReportid, bool pLocal)
 {
+  ReportCache::instance()->clear();
   emit reportsChanged(pReportid, pLocal);
 }
 
@@ -2573,31 +2754,49 @@ void GUIClient::hunspell_initialize()
       affFile.setFileName(fullPathWithoutExt + tr(".aff"));
       dicFile.setFileName(fullPathWithoutExt + tr(".dic"));
     }
-    if(affFile.exists() && dicFile.exists())
-    {
-      _spellReady = true;
-    }
-    _spellChecker = new Hunspell(QString(fullPathWithoutExt+tr(".aff")).toLatin1(),
-                                 QString(fullPathWithoutExt+tr(".dic")).toLatin1());
+    if(!(affFile.exists() && dicFile.exists()))
+      return;
+
+    QString homePath = QDir::homePath().toLatin1();
+    QString userDic;
+    if(QFile::exists(homePath + tr("/xTuple/user.dic")))
+      userDic = homePath + tr("/xTuple/user.dic"); //open user dictionary if exists
+
+    // spell checking starts when sHunspellLoaded() runs
+    _spellLoader = new GUIClientHunspellLoader(fullPathWithoutExt, userDic, this);
+    connect(_spellLoader, SIGNAL(finished()), this, SLOT(sHunspellLoaded()));
+    _spellLoader->start(QThread::LowPriority);
+}
+
+void GUIClient::sHunspellLoaded()
+{
+    GUIClientHunspellLoader *loader = static_cast<GUIClientHunspellLoader*>(_spellLoader);
+    if (! loader)
+      return;
+
+    _spellChecker = loader->takeChecker();
+    _spellLoader = 0;
+    loader->deleteLater();
 
     QString spell_encoding = QString(_spellChecker->get_dic_encoding());
     _spellCodec = QTextCodec::codecForName(spell_encoding.toLocal8Bit());
+    _spellCache.clear();
+    _spellReady = true;
 
-    QString homePath = QDir::homePath().toLatin1();
-    if(_spellReady)
-    {
-        QFile file(homePath + tr("/xTuple/user.dic"));
-        if(file.exists(homePath + tr("/xTuple/user.dic")))
-        {
-           //open user dictionary if exists
-           _spellChecker->add_dic(QString(homePath + tr("/xTuple/user.dic")).toLatin1());
-        }
-    }
+    // text already on screen was highlighted without a dictionary
+    XTextEditHighlighter::rehighlightAll();
 }
 
 void GUIClient::hunspell_uninitialize()
 {
+    if (_spellLoader)
+    {
+      delete _spellLoader; // waits for the dictionary before deleting it
+      _spellLoader = 0;
+    }
     delete (Hunspell *)(_spellChecker);
+    _spellChecker = 0;
+    _spellCache.clear();
     QString homePath = QDir::homePath().toLatin1();
     QFile file(homePath + tr("/xTuple/user.dic"));
 
@@ -2641,6 +2840,7 @@ void GUIClient::hunspell_uninitialize()
          file.close();
       }
     }
+    _spellReady = false;
 }
 
 bool GUIClient::hunspell_ready()
@@ -2650,17 +2850,26 @@ bool GUIClient::hunspell_ready()
 
 int GUIClient::hunspell_check(const QString word)
 {
+      if (! _spellReady)
+        return 0;
+
+      int *cached = _spellCache.object(word);
+      if (cached)
+        return *cached;
+
       QByteArray encodedString = _spellCodec->fromUnicode(word);
-      return _spellChecker->spell(encodedString.data());
+      int result = _spellChecker->spell(encodedString.data());
+      _spellCache.insert(word, new int(result));
+      return result;
 }
 
 const QStringList GUIClient::hunspell_suggest(const QString word)
 {
     char **wlst;
     QStringList wordList;
-    QByteArray encodedString = _spellCodec->fromUnicode(word);
-    if(_spellChecker->spell(encodedString.data()) < 1)
+    if(_spellReady && hunspell_check(word) < 1)
     {
+      QByteArray encodedString = _spellCodec->fromUnicode(word);
       int suggestNum = _spellChecker->suggest(&wlst, encodedString.data());
       if (suggestNum > 0)
       {
@@ -2674,16 +2883,24 @@ const QStringList GUIClient::hunspell_suggest(const QString word)
 
 int GUIClient::hunspell_add(const QString word)
 {
+    if (! _spellReady)
+      return 0;
+
     QByteArray encodedString = _spellCodec->fromUnicode(word);
     //check if word has been added before
     if(!_spellAddWords.contains(encodedString.data()))
         _spellAddWords.append(encodedString.data());
+    _spellCache.remove(word);
     return _spellChecker->add(encodedString.data());
 }
 
 int GUIClient::hunspell_ignore(const QString word)
 {
+    if (! _spellReady)
+      return 0;
+
     QByteArray encodedString = _spellCodec->fromUnicode(word);
+    _spellCache.remove(word);
     return _spellChecker->add(encodedString.data());
 }
 
@@ -12,6 +12,7 @@
 #define GUICLIENT_H
 
 #include <QAction>
+#include <QCache>
 #include <QDate>
 #include <QList>
 #include <QMainWindow>
@@ -174,6 +175,7 @@ class GUIClient : public QMainWindow
 
     Q_INVOKABLE void setCaption();
     Q_INVOKABLE void saveToolbarPositions();
+    Q_INVOKABLE void completeMenuBar();
 
     Q_INVOKABLE inline QMdiArea *workspace()         { return _workspace;    }
     Q_INVOKABLE inline InputManager *inputManager()    { return _inputManager; }
@@ -398,8 +400,10 @@ class GUIClient : public QMainWindow
 
   private slots:
     void handleDocument(QString path);
+    void sBuildNextMenu();
     void hunspell_initialize();
     void hunspell_uninitialize();
+    void sHunspellLoaded();
 
   private:
     QMdiArea   *_workspace;
@@ -457,10 +461,17 @@ class GUIClient : public QMainWindow
     QMap<QString, int> _fileMap;
     QTextCodec * _spellCodec;
     Hunspell * _spellChecker;
+    QThread * _spellLoader;
     bool _spellReady;
     QStringList _spellAddWords;
+    QCache<QString, int> _spellCache; // hunspell_check() results
 
     QMenu *_menu;
+
+    int  _menuBuildStep; // next module menu to build, -1 when complete
+    bool buildNextMenu();
+    void setMenuBarVisibility();
+    void runInitMenuScripts();
 };
 extern GUIClient *omfgThis;
 
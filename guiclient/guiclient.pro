@@ -1058,6 +1058,7 @@ HEADERS = ../common/format.h                    \
           releaseTransferOrdersByAgent.h        \
           releaseWorkOrdersByPlannerCode.h      \
           relocateInventory.h                   \
+          reportcache.h                         \
           reports.h                             \
           reprintCreditMemos.h                  \
           reprintInvoices.h                     \
@@ -1092,6 +1093,7 @@ HEADERS = ../common/format.h                    \
           scrapTrans.h                          \
           scrapWoMaterialFromWIP.h              \
           scriptablePrivate.h                   \
+          scriptcache.h                         \
           scriptEditor.h                        \
           scripts.h                             \
           scripttoolbox.h                       \
@@ -1667,6 +1669,7 @@ SOURCES = absoluteCalendarItem.cpp              \
           releaseTransferOrdersByAgent.cpp      \
           releaseWorkOrdersByPlannerCode.cpp    \
           relocateInventory.cpp                 \
+          reportcache.cpp                       \
           reports.cpp                           \
           reprintCreditMemos.cpp                \
           reprintInvoices.cpp                   \
@@ -1701,6 +1704,7 @@ SOURCES = absoluteCalendarItem.cpp              \
           scrapTrans.cpp                        \
           scrapWoMaterialFromWIP.cpp            \
           scriptablePrivate.cpp                 \
+          scriptcache.cpp                       \
           scriptEditor.cpp                      \
           scripts.cpp                           \
           scripttoolbox.cpp                     \
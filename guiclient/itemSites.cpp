@@ -67,7 +67,7 @@ itemSites::itemSites(QWidget* parent, const char*, Qt::WindowFlags fl)
   list()->addColumn(tr("Last Cnt'd"),    _dateColumn,  Qt::AlignCenter, false,  "datelastcount" );
   list()->addColumn(tr("Last Used"),     _dateColumn,  Qt::AlignCenter, false,  "datelastused" );
 
-  connect(omfgThis, SIGNAL(itemsitesUpdated()), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(itemsitesUpdated()), this, SLOT(sScheduleFillList()));
 }
 
 enum SetResponse itemSites::set(const ParameterList &pParams)
@@ -96,6 +96,8 @@
 #include <QSplashScreen>
 #include <QSqlDatabase>
 #include <QSqlError>
+#include <QSqlQuery>
+#include <QSqlRecord>
 #include <QTranslator>
 #if QT_VERSION < 0x050000
 #include <QHttp>
@@ -123,6 +125,7 @@
 #include "sysLocale.h"
 
 #include "splashconst.h"
+#include "xsqlconnectionpool.h"
 #include "xtsettings.h"
 #include "welcomeStub.h"
 
@@ -133,6 +136,171 @@ QString __password;
 
 #define DEBUG false
 
+/* Read the user's locale and load its translation files. Neither depends
+   on the preferences or privileges, so main() runs this on a pooled
+   connection while those load, or calls load() directly if it can't.
+ */
+class mainTranslationTask : public XSqlPoolTask
+{
+  public:
+    mainTranslationTask()
+      : _loaded(false)
+    {
+    }
+
+    ~mainTranslationTask()
+    {
+      qDeleteAll(_translators);
+    }
+
+    void load(QSqlDatabase &db)
+    {
+      _loaded = true;
+
+      QSqlQuery langq(db);
+      langq.exec("SELECT locale_lang_file,"
+                 "       lang_abbr2, lang_qt_number,"
+                 "       country_abbr, country_qt_number"
+                 "  FROM usr"
+                 "  JOIN locale ON (usr_locale_id=locale_id)"
+                 "  LEFT OUTER JOIN lang ON (locale_lang_id=lang_id)"
+                 "  LEFT OUTER JOIN country ON (locale_country_id=country_id)"
+                 " WHERE (usr_username=getEffectiveXtUser());");
+      if (! langq.first())
+      {
+        _error = langq.lastError();
+        return;
+      }
+      _locale = langq.record();
+
+      QStringList files;
+      if (!_locale.value("locale_lang_file").toString().isEmpty())
+        files << _locale.value("locale_lang_file").toString();
+
+      QString langext;
+      if (!_locale.value("lang_abbr2").toString().isEmpty() &&
+          !_locale.value("country_abbr").toString().isEmpty())
+      {
+        langext = _locale.value("lang_abbr2").toString() + "_" +
+                  _locale.value("country_abbr").toString().toLower();
+      }
+      else if (!_locale.value("lang_abbr2").toString().isEmpty())
+      {
+        langext = _locale.value("lang_abbr2").toString();
+      }
+
+      if(!langext.isEmpty())
+      {
+        files << "qt";
+        files << "xTuple";
+        files << "openrpt";
+        files << "reports";
+
+        QSqlQuery pkglist(db);
+        pkglist.exec("SELECT pkghead_name"
+                     "  FROM pkghead"
+                     " WHERE packageIsEnabled(pkghead_name);");
+        while(pkglist.next())
+          files << pkglist.value(0).toString();
+      }
+
+      foreach (QString file, files)
+      {
+        if (DEBUG)
+          qDebug("looking for %s", qPrintable(file));
+        QTranslator *translator = new QTranslator();
+        if (translator->load(translationFile(langext, file)))
+        {
+          translator->moveToThread(QCoreApplication::instance()->thread());
+          _translators.append(translator);
+          _found.append(file);
+        }
+        else
+        {
+          delete translator;
+          _notfound << file;
+        }
+      }
+    }
+
+    bool        loaded()   const { return _loaded;   }
+    QSqlError   error()    const { return _error;    }
+    QSqlRecord  locale()   const { return _locale;   }
+    QStringList found()    const { return _found;    }
+    QStringList notfound() const { return _notfound; }
+
+    QList<QTranslator*> takeTranslators()
+    {
+      QList<QTranslator*> result = _translators;
+      _translators.clear();
+      return result;
+    }
+
+  protected:
+    virtual void run(QSqlDatabase &db)
+    {
+      if (db.isOpen())
+        load(db);
+    }
+
+  private:
+    bool                _loaded;
+    QSqlError           _error;
+    QSqlRecord          _locale;
+    QList<QTranslator*> _translators;
+    QStringList         _found;
+    QStringList         _notfound;
+};
+
+/* Check the fiscal period and exchange rates for the current date. main()
+   starts this when the main window exists and reads the answers after
+   the base currency check, which may need the user's help first.
+ */
+class mainConfigurationCheckTask : public XSqlPoolTask
+{
+  public:
+    mainConfigurationCheckTask()
+      : _loaded(false),
+        _periodOpen(true),
+        _ratesMissing(false)
+    {
+    }
+
+    void load(QSqlDatabase &db)
+    {
+      _loaded = true;
+
+      QSqlQuery periodCheck(db);
+      periodCheck.exec("SELECT EXISTS(SELECT * FROM period "
+                       "     WHERE ((current_date BETWEEN period_start AND period_end) "
+                       "       AND (NOT period_closed))) AS result; ");
+      _periodOpen = ! periodCheck.first() || periodCheck.value(0).toBool();
+
+      QSqlQuery xrateCheck(db);
+      xrateCheck.exec("SELECT curr_abbr"
+                      "  FROM curr_symbol s JOIN curr_rate r ON s.curr_id = r.curr_id"
+                      "  GROUP BY curr_abbr"
+                      "  HAVING NOT BOOL_OR(current_date BETWEEN curr_effective AND curr_expires);");
+      _ratesMissing = xrateCheck.first();
+    }
+
+    bool loaded()       const { return _loaded;       }
+    bool periodOpen()   const { return _periodOpen;   }
+    bool ratesMissing() const { return _ratesMissing; }
+
+  protected:
+    virtual void run(QSqlDatabase &db)
+    {
+      if (db.isOpen())
+        load(db);
+    }
+
+  private:
+    bool _loaded;
+    bool _periodOpen;
+    bool _ratesMissing;
+};
+
 #if QT_VERSION >= 0x050000
 extern void xTupleMessageOutput(QtMsgType type, const QMessageLogContext &context, const QString &msg);
 #else
@@ -303,6 +471,10 @@ int main(int argc, char *argv[])
   qApp->processEvents();
   _metrics = new Metrics();
 
+  // each pooled connection is another database session, so only on request
+  if (_metrics->value("PooledConnections").toInt() > 1)
+    XSqlConnectionPool::instance()->setMaxConnections(_metrics->value("PooledConnections").toInt());
+
   // TODO: can/should we compose the splash screen on the fly from parts?
   QList<editionDesc> edition;
   edition << editionDesc( "Enterprise",     ":/images/splashEnterprise.png",        true,
@@ -536,6 +708,12 @@ int main(int argc, char *argv[])
     }
   }
 
+
+  mainTranslationTask *translationTask = new mainTranslationTask();
+  bool translationThreaded = XSqlConnectionPool::canRunThreaded();
+  if (translationThreaded)
+    translationTask->start();
+
   _splash->showMessage(QObject::tr("Loading User Preferences"), SplashTextAlignment, SplashTextColor);
   qApp->processEvents();
   _preferences = new Preferences(username);
@@ -547,74 +725,33 @@ int main(int argc, char *argv[])
   // Load the translator and set the locale from the User's preferences
   _splash->showMessage(QObject::tr("Loading Translation Dictionary"), SplashTextAlignment, SplashTextColor);
   qApp->processEvents();
-  XSqlQuery langq("SELECT locale_lang_file,"
-                  "       lang_abbr2, lang_qt_number,"
-                  "       country_abbr, country_qt_number"
-                  "  FROM usr"
-                  "  JOIN locale ON (usr_locale_id=locale_id)"
-                  "  LEFT OUTER JOIN lang ON (locale_lang_id=lang_id)"
-                  "  LEFT OUTER JOIN country ON (locale_country_id=country_id)"
-                  " WHERE (usr_username=getEffectiveXtUser());");
-  if (langq.first())
+  if (translationThreaded)
+    translationTask->wait();
+  if (! translationTask->loaded())
   {
-    QStringList files;
-    if (!langq.value("locale_lang_file").toString().isEmpty())
-      files << langq.value("locale_lang_file").toString();
-
-    QString langext;
-    if (!langq.value("lang_abbr2").toString().isEmpty() && 
-        !langq.value("country_abbr").toString().isEmpty())
-    {
-      langext = langq.value("lang_abbr2").toString() + "_" +
-                langq.value("country_abbr").toString().toLower();
-    }
-    else if (!langq.value("lang_abbr2").toString().isEmpty())
-    {
-      langext = langq.value("lang_abbr2").toString();
-    }
-
-    if(!langext.isEmpty())
-    {
-      files << "qt";
-      files << "xTuple";
-      files << "openrpt";
-      files << "reports";
-
-      XSqlQuery pkglist("SELECT pkghead_name"
-                        "  FROM pkghead"
-                        " WHERE packageIsEnabled(pkghead_name);");
-      while(pkglist.next())
-        files << pkglist.value("pkghead_name").toString();
-    }
+    QSqlDatabase db = QSqlDatabase::database();
+    translationTask->load(db);
+  }
 
-    if (files.size() > 0)
+  QSqlRecord langq = translationTask->locale();
+  if (! langq.isEmpty())
+  {
+    foreach (QTranslator *translator, translationTask->takeTranslators())
     {
-      QStringList notfound;
-      QTranslator *translator = new QTranslator(&app);
-      for (QStringList::Iterator fit = files.begin(); fit != files.end(); ++fit)
-      {
-        if (DEBUG)
-          qDebug("looking for %s", (*fit).toLatin1().data());
-        if (translator->load(translationFile(langext, *fit)))
-        {
-          app.installTranslator(translator);
-          qDebug("installed %s", (*fit).toLatin1().data());
-          translator = new QTranslator(&app);
-        }
-        else
-        {
-          notfound << *fit;
-        }
-      }
-
-      if (! notfound.isEmpty() &&
-          !_preferences->boolean("IngoreMissingTranslationFiles"))
-        QMessageBox::warning( 0, QObject::tr("Cannot Load Dictionary"),
-                              QObject::tr("<p>The Translation Dictionaries %1 "
-                                          "cannot be loaded. Reverting "
-                                          "to the default dictionary." )
-                                       .arg(notfound.join(QObject::tr(", "))));
+      translator->setParent(&app);
+      app.installTranslator(translator);
     }
+    foreach (QString file, translationTask->found())
+      qDebug("installed %s", file.toLatin1().data());
+
+    QStringList notfound = translationTask->notfound();
+    if (! notfound.isEmpty() &&
+        !_preferences->boolean("IngoreMissingTranslationFiles"))
+      QMessageBox::warning( 0, QObject::tr("Cannot Load Dictionary"),
+                            QObject::tr("<p>The Translation Dictionaries %1 "
+                                        "cannot be loaded. Reverting "
+                                        "to the default dictionary." )
+                                     .arg(notfound.join(QObject::tr(", "))));
 
     /* set the locale to langabbr_countryabbr, langabbr, {lang# country#}, or
        lang#, depending on what information is available
@@ -644,7 +781,11 @@ int main(int argc, char *argv[])
   else
     ErrorReporter::error(QtCriticalMsg, 0,
                          QObject::tr("Error Getting Locale"),
-                         langq, __FILE__, __LINE__);
+                         translationTask->error(), __FILE__, __LINE__);
+  if (translationThreaded)
+    translationTask->deleteWhenFinished();
+  else
+    delete translationTask;
 
   qApp->processEvents();
   QString key;
@@ -698,6 +839,11 @@ int main(int argc, char *argv[])
   omfgThis = new GUIClient(databaseURL, username);
   omfgThis->_key = key;
 
+  mainConfigurationCheckTask *checkTask = new mainConfigurationCheckTask();
+  bool checkThreaded = XSqlConnectionPool::canRunThreaded();
+  if (checkThreaded)
+    checkTask->start();
+
   if (key.length() > 0) {
 	_splash->showMessage(QObject::tr("Loading Database Encryption Metrics"), SplashTextAlignment, SplashTextColor);
 	qApp->processEvents();
@@ -812,13 +958,16 @@ int main(int argc, char *argv[])
                     "transactions in the system.") );
   }
 
+  if (checkThreaded)
+    checkTask->wait();
+  if (! checkTask->loaded())
+  {
+    QSqlDatabase db = QSqlDatabase::database();
+    checkTask->load(db);
+  }
+
 //  Check for valid current Fiscal period
-  XSqlQuery periodCheck;
-  periodCheck.prepare("SELECT EXISTS(SELECT * FROM period "
-            "     WHERE ((current_date BETWEEN period_start AND period_end) "
-            "       AND (NOT period_closed))) AS result; ");
-  periodCheck.exec();
-  if(periodCheck.first() && periodCheck.value("result").toBool() != true)
+  if(! checkTask->periodOpen())
     QMessageBox::warning( omfgThis, QObject::tr("Additional Configuration Required"),
       QObject::tr("<p>Your system does not have a valid or open Accounting period "
                   "for the current date. "
@@ -827,11 +976,7 @@ int main(int argc, char *argv[])
                   "transactions in the system.") );
 
 //  Check for valid current exchange rates
-  XSqlQuery xrateCheck("SELECT curr_abbr"
-	          "  FROM curr_symbol s JOIN curr_rate r ON s.curr_id = r.curr_id"
-	          "  GROUP BY curr_abbr"
-	          "  HAVING NOT BOOL_OR(current_date BETWEEN curr_effective AND curr_expires);");
-  if (xrateCheck.first())
+  if (checkTask->ratesMissing())
     QMessageBox::warning( omfgThis, QObject::tr("Additional Configuration Required"),
       QObject::tr("<p>Your system has alternate currencies without exchange rates "
                   "entered for the current date. "
@@ -839,6 +984,11 @@ int main(int argc, char *argv[])
                   "Setup | Exchange Rates...' before posting any "
                   "transactions in the system.") );
 
+  if (checkThreaded)
+    checkTask->deleteWhenFinished();
+  else
+    delete checkTask;
+
   app.exec();
 
 //  Clean up
@@ -18,6 +18,7 @@
 
 #include "mqlutil.h"
 #include "errorReporter.h"
+#include "scriptcache.h"
 #include "storedProcErrorLookup.h"
 
 #define DEBUG false
@@ -272,6 +273,7 @@ void package::sSave()
       systemError(this, eq.lastError().databaseText(), __FILE__, __LINE__);
       return;
     }
+    ScriptCache::instance()->clear();
   }
 
   done(_pkgheadid);
@@ -20,6 +20,7 @@
 #include <openreports.h>
 
 #include "package.h"
+#include "scriptcache.h"
 #include "storedProcErrorLookup.h"
 
 packages::packages(QWidget* parent, const char* name, Qt::WindowFlags fl)
@@ -123,6 +124,7 @@ void packages::sDelete()
     return;
   }
 
+  ScriptCache::instance()->clear();
   sFillList();
 }
 
@@ -188,6 +190,7 @@ void packages::sLoad()
       proc.exitCode() == 0)
   {
     QApplication::restoreOverrideCursor();
+    ScriptCache::instance()->clear();
     sFillList();
   }
   else
@@ -301,6 +304,7 @@ void packages::sEnable()
     systemError(this, eq.lastError().databaseText(), __FILE__, __LINE__);
     return;
   }
+  ScriptCache::instance()->clear();
   sFillList();
 }
 
@@ -326,6 +330,7 @@ void packages::sDisable()
     systemError(this, dq.lastError().databaseText(), __FILE__, __LINE__);
     return;
   }
+  ScriptCache::instance()->clear();
   sFillList();
 }
 
@@ -20,6 +20,7 @@
 
 #include "distributeInventory.h"
 #include "errorReporter.h"
+#include "reportcache.h"
 #include "storedProcErrorLookup.h"
 
 class printMulticopyDocumentPrivate : public Ui::printMulticopyDocument
@@ -385,8 +386,10 @@ bool printMulticopyDocument::sPrintOneDoc(XSqlQuery *docq)
     }
   }
 
-  orReport report(reportname);
-  if (! report.isValid())
+  // every document in the batch shares one parsed copy of its form
+  orReport     report;
+  QDomDocument definition = ReportCache::instance()->definition(reportname);
+  if (definition.isNull() || ! report.setDom(definition))
     QMessageBox::critical(this, tr("Cannot Find Form"),
                           tr("<p>Cannot find form '%1' for %2 %3. "
                              "It cannot be printed until the Form "
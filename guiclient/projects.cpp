@@ -76,7 +76,7 @@ projects::projects(QWidget* parent, const char*, Qt::WindowFlags fl)
   _incidents->setChecked(false);
   _showHierarchy->setChecked(false);
 
-  connect(omfgThis, SIGNAL(projectsUpdated(int)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(projectsUpdated(int)), this, SLOT(sScheduleFillList(int)));
   connect(_showComplete, SIGNAL(toggled(bool)), this, SLOT(sFillList()));
 //  connect(_salesOrders, SIGNAL(toggled(bool)), this, SLOT(sFillList()));
 //  connect(_workOrders, SIGNAL(toggled(bool)), this, SLOT(sFillList()));
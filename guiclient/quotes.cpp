@@ -74,7 +74,7 @@ quotes::quotes(QWidget* parent, const char *name, Qt::WindowFlags fl)
     connect(list(), SIGNAL(itemSelected(int)), this, SLOT(sView()));
   }
 
-  connect(omfgThis, SIGNAL(quotesUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(quotesUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 }
 
 enum SetResponse quotes::set(const ParameterList& pParams)
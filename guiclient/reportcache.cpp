@@ -0,0 +1,101 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#include "reportcache.h"
+
+#include <QApplication>
+#include <QSqlError>
+
+#include "xsqlquery.h"
+
+#define DEBUG false
+
+ReportCache *ReportCache::_instance = 0;
+
+ReportCache *ReportCache::instance()
+{
+  if (! _instance)
+    _instance = new ReportCache(qApp);
+  return _instance;
+}
+
+ReportCache::ReportCache(QObject *parent)
+  : QObject(parent)
+{
+  setObjectName("ReportCache");
+}
+
+ReportCache::~ReportCache()
+{
+  if (_instance == this)
+    _instance = 0;
+}
+
+QDomDocument ReportCache::definition(const QString &name, int grade,
+                                     QString *errmsg, int *errline)
+{
+  if (_loaded.isValid() && _loaded.elapsed() > maxAge * 1000)
+    clear();
+
+  QString key = QString("%1:%2").arg(name).arg(grade);
+  QHash<QString, QDomDocument>::const_iterator it = _definitions.constFind(key);
+  if (it != _definitions.constEnd())
+    return it.value();
+
+  XSqlQuery reportq;
+  reportq.prepare("SELECT report_source"
+                  "  FROM report"
+                  " WHERE ((report_name=:report_name)"
+                  "   AND  ((report_grade=:report_grade) OR (:report_grade = -1)))"
+                  " ORDER BY report_grade DESC LIMIT 1;");
+  reportq.bindValue(":report_name",  name);
+  reportq.bindValue(":report_grade", grade);
+  reportq.exec();
+
+  QDomDocument doc;
+  if (reportq.first())
+  {
+    QString message;
+    int     line = 0;
+    if (! doc.setContent(reportq.value("report_source").toString(),
+                         &message, &line))
+    {
+      if (errmsg)
+        *errmsg = message;
+      if (errline)
+        *errline = line;
+      return QDomDocument();
+    }
+  }
+  else
+  {
+    if (reportq.lastError().type() != QSqlError::NoError)
+      qWarning("ReportCache::definition(%s) could not load: %s",
+               qPrintable(key), qPrintable(reportq.lastError().text()));
+    return doc;
+  }
+
+  if (DEBUG)
+    qDebug("ReportCache::definition(%s) parsed", qPrintable(key));
+
+  if (_definitions.isEmpty())
+    _loaded.start();
+  _definitions.insert(key, doc);
+  return doc;
+}
+
+void ReportCache::clear()
+{
+  if (DEBUG)
+    qDebug("ReportCache::clear() dropping %d definitions", _definitions.size());
+
+  _definitions.clear();
+  _loaded = QTime();
+}
@@ -0,0 +1,55 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#ifndef __REPORTCACHE_H__
+#define __REPORTCACHE_H__
+
+#include <QDomDocument>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QTime>
+
+/* Process-wide cache of parsed report definitions, keyed by report name
+   and grade. A grade of -1 means the highest grade, which is what
+   orReport picks when given just a name.
+
+   definition() returns a null document if the report does not exist or
+   cannot be parsed; errmsg and errline are only set in the second case.
+   Nothing tells this client when another one edits a report, so the
+   definitions are dropped once they are maxAge seconds old, and
+   immediately when clear() is called after an edit here.
+ */
+class ReportCache : public QObject
+{
+  Q_OBJECT
+
+  public:
+    static ReportCache *instance();
+
+    QDomDocument definition(const QString &name, int grade = -1,
+                            QString *errmsg = 0, int *errline = 0);
+
+    static const int maxAge = 60;
+
+  public slots:
+    void clear();
+
+  private:
+    ReportCache(QObject *parent = 0);
+    ~ReportCache();
+
+    static ReportCache *_instance;
+
+    QHash<QString, QDomDocument> _definitions; // <name:grade, definition>
+    QTime                        _loaded;      // when _definitions was first filled
+};
+
+#endif
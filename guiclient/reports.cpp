@@ -21,6 +21,7 @@
 #include <reporthandler.h>
 
 #include "errorReporter.h"
+#include "reportcache.h"
 
 reports::reports(QWidget* parent, const char* name, Qt::WindowFlags fl)
     : XWidget(parent, name, fl)
@@ -174,6 +175,7 @@ void reports::sDelete()
                              delq, __FILE__, __LINE__))
       return;
 
+    ReportCache::instance()->clear();
     sFillList();
   }
 }
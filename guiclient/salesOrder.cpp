@@ -17,6 +17,7 @@
 #include <QMenu>
 #include <QMessageBox>
 #include <QSqlError>
+#include <QSqlRecord>
 #include <QValidator>
 #include <QVariant>
 
@@ -4175,180 +4176,260 @@ void salesOrder::sIssueStock()
 
 void salesOrder::sIssueLineBalance()
 {
-  XSqlQuery issueSales;
-  bool job = false;
+  // skip closed and cancelled lines
   QList<XTreeWidgetItem *> selected = _soitem->selectedItems();
+  QList<QVariant>          soitemids;
+  QHash<int, QString>      linenumbers;
   for (int i = 0; i < selected.size(); i++)
   {
     XTreeWidgetItem *soitem = (XTreeWidgetItem *)(selected[i]);
     if (soitem->altId() != 1 && soitem->altId() != 4)
     {
-      // sufficientInventoryToShipItem assumes line balance if qty not passed
-      issueSales.prepare("SELECT itemsite_id, item_number, warehous_code, itemsite_costmethod, "
-                  "       sufficientInventoryToShipItem('SO', coitem_id) AS isqtyavail "
-                  "  FROM coitem JOIN itemsite ON (itemsite_id=coitem_itemsite_id)"
-                  "              JOIN item ON (item_id=itemsite_item_id)"
-                  "              JOIN whsinfo ON (warehous_id=itemsite_warehous_id) "
-                  " WHERE (coitem_id=:soitem_id); ");
-      issueSales.bindValue(":soitem_id", soitem->id());
-      issueSales.exec();
-      if (issueSales.lastError().type() != QSqlError::NoError)
+      soitemids.append(soitem->id());
+      linenumbers.insert(soitem->id(), soitem->text(0));
+    }
+  }
+  if (soitemids.isEmpty())
+    return;
+
+  // check all of the lines in one round trip before issuing any of them.
+  // sufficientInventoryToShipItem assumes line balance if qty not passed.
+  // it only sees one line, so also compare the balance of all selected
+  // lines for the same itemsite, in inventory uom, with what is on hand
+  ParameterList checkp;
+  checkp.append("soitem_id", QVariant(soitemids));
+  MetaSQLQuery checkm("SELECT coitem_id, item_number, warehous_code, itemsite_costmethod,"
+                      "       CASE WHEN (isqtyavail >= 0 AND iscontrolled"
+                      "                  AND qtyonhand < SUM(needed) OVER (PARTITION BY itemsite_id)) THEN -1"
+                      "            ELSE isqtyavail"
+                      "       END AS isqtyavail,"
+                      "       isdistributed"
+                      "  FROM (SELECT coitem_id, item_number, warehous_code, itemsite_id, itemsite_costmethod,"
+                      "               sufficientInventoryToShipItem('SO', coitem_id) AS isqtyavail,"
+                      "               NOT ((item_type = 'R') OR (itemsite_controlmethod = 'N')) AS iscontrolled,"
+                      "               (NOT ((item_type = 'R') OR (itemsite_controlmethod = 'N'))"
+                      "                AND ((itemsite_controlmethod IN ('L', 'S')) OR (itemsite_loccntrl))) AS isdistributed,"
+                      "               itemsite_qtyonhand AS qtyonhand,"
+                      "               CASE WHEN (itemsite_costmethod = 'J') THEN 0"
+                      "                    ELSE noNeg(coitem_qtyord - coitem_qtyshipped +"
+                      "                               coitem_qtyreturned - qtyAtShipping(coitem_id)) * coitem_qty_invuomratio"
+                      "               END AS needed"
+                      "          FROM coitem JOIN itemsite ON (itemsite_id=coitem_itemsite_id)"
+                      "                      JOIN item ON (item_id=itemsite_item_id)"
+                      "                      JOIN whsinfo ON (warehous_id=itemsite_warehous_id)"
+                      "         WHERE (coitem_id IN ("
+                      "<? foreach('soitem_id') ?>"
+                      "  <? if not isfirst('soitem_id') ?>, <? endif ?>"
+                      "  <? value('soitem_id') ?>"
+                      "<? endforeach ?>"
+                      "))) AS line;");
+  XSqlQuery checkq = checkm.toQuery(checkp);
+  if (checkq.lastError().type() != QSqlError::NoError)
+  {
+    systemError(this, checkq.lastError().databaseText(), __FILE__, __LINE__);
+    return;
+  }
+
+  QHash<int, QSqlRecord> lines;
+  while (checkq.next())
+    lines.insert(checkq.value("coitem_id").toInt(), checkq.record());
+
+  QList<QVariant> jobids;
+  QList<QVariant> issueids;       // need no distribution, issued together
+  QList<QVariant> distributeids;  // may need distribution, issued one by one
+  foreach (QVariant soitemid, soitemids)
+  {
+    if (! lines.contains(soitemid.toInt()))
+      continue;
+
+    QSqlRecord line = lines.value(soitemid.toInt());
+    bool       job  = (line.value("itemsite_costmethod").toString() == "J");
+    if (! job && line.value("isqtyavail").toInt() < 0)
+    {
+      if (_requireInventory->isChecked())
       {
-        systemError(this, issueSales.lastError().databaseText(), __FILE__, __LINE__);
+        QMessageBox::critical(this, tr("Insufficient Inventory"),
+                                    tr("<p>There is not enough Inventory to issue the amount required"
+                                       " of Item %1 in Site %2.")
+                              .arg(line.value("item_number").toString())
+                              .arg(line.value("warehous_code").toString()) );
         return;
       }
-      while (issueSales.next())
+      if (line.value("isdistributed").toBool())
       {
-        if (issueSales.value("itemsite_costmethod").toString() == "J")
-          job = true;
-
-        if (_requireInventory->isChecked() &&
-            issueSales.value("isqtyavail").toInt() < 0 &&
-            issueSales.value("itemsite_costmethod").toString() != "J")
-        {
-          QMessageBox::critical(this, tr("Insufficient Inventory"),
-                                      tr("<p>There is not enough Inventory to issue the amount required"
-                                         " of Item %1 in Site %2.")
-                                .arg(issueSales.value("item_number").toString())
-                                .arg(issueSales.value("warehous_code").toString()) );
-          return;
-        }
+        QMessageBox::critical(this, tr("Insufficient Inventory"),
+                                tr("<p>Item Number %1 in Site %2 is a Multiple Location or "
+                                   "Lot/Serial controlled Item which is short on Inventory. "
+                                   "This transaction cannot be completed as is. Please make "
+                                   "sure there is sufficient Quantity on Hand before proceeding.")
+                              .arg(line.value("item_number").toString())
+                              .arg(line.value("warehous_code").toString()));
+        return;
       }
+    }
+
+    if (job)
+      jobids.append(soitemid);
+    else if (line.value("isdistributed").toBool())
+      distributeids.append(soitemid);
+    else
+      issueids.append(soitemid);
+  }
+
+  XSqlQuery rollback;
+  rollback.prepare("ROLLBACK;");
 
-      issueSales.prepare("SELECT itemsite_id, itemsite_costmethod, item_number, warehous_code, "
-                "       sufficientInventoryToShipItem('SO', coitem_id) AS isqtyavail "
-                "  FROM coitem JOIN itemsite ON (itemsite_id=coitem_itemsite_id)"
-                "              JOIN item ON (item_id=itemsite_item_id)"
-                "              JOIN whsinfo ON (warehous_id=itemsite_warehous_id) "
-                " WHERE ((coitem_id=:soitem_id) "
-                "   AND (NOT ((item_type = 'R') OR (itemsite_controlmethod = 'N'))) "
-                "   AND ((itemsite_controlmethod IN ('L', 'S')) OR (itemsite_loccntrl)));");
-      issueSales.bindValue(":soitem_id", soitem->id());
-      issueSales.exec();
-      if (issueSales.lastError().type() != QSqlError::NoError)
+  /* lines that need no distribution can't be canceled half way, so they
+     are issued together in one transaction. lines that may need lot,
+     serial, or location distribution each get their own, so canceling
+     one distribution only rolls back that line, as it always has.
+   */
+  QList<QList<QVariant> > transactions;
+  if (! issueids.isEmpty())
+    transactions.append(issueids);
+  foreach (QVariant soitemid, distributeids)
+    transactions.append(QList<QVariant>() << soitemid);
+
+  foreach (QList<QVariant> transactionids, transactions)
+  {
+    ParameterList issuep;
+    issuep.append("soitem_id", QVariant(transactionids));
+
+    XSqlQuery begin("BEGIN;"); // because of possible lot, serial, or location distribution cancelations
+    MetaSQLQuery issuem("SELECT coitem_id,"
+                        "       issueLineBalanceToShipping('SO', coitem_id, now(),"
+                        "                                  NULL::INTEGER, NULL::INTEGER) AS result"
+                        "  FROM coitem"
+                        " WHERE (coitem_id IN ("
+                        "<? foreach('soitem_id') ?>"
+                        "  <? if not isfirst('soitem_id') ?>, <? endif ?>"
+                        "  <? value('soitem_id') ?>"
+                        "<? endforeach ?>"
+                        "))"
+                        " ORDER BY coitem_linenumber, coitem_subnumber;");
+    XSqlQuery issueq = issuem.toQuery(issuep);
+    if (issueq.lastError().type() != QSqlError::NoError)
+    {
+      rollback.exec();
+      systemError(this, issueq.lastError().databaseText(), __FILE__, __LINE__);
+      return;
+    }
+    while (issueq.next())
+    {
+      int result = issueq.value("result").toInt();
+      if (result < 0)
       {
-        systemError(this, issueSales.lastError().databaseText(), __FILE__, __LINE__);
+        rollback.exec();
+        systemError(this, storedProcErrorLookup("issueLineBalanceToShipping", result) +
+                    tr("<br>Line Item %1").arg(linenumbers.value(issueq.value("coitem_id").toInt())),
+                    __FILE__, __LINE__);
         return;
       }
-      while (issueSales.next())
+
+      if (distributeInventory::SeriesAdjust(result, this) == XDialog::Rejected)
       {
-        if (issueSales.value("isqtyavail").toInt() < 0 && issueSales.value("itemsite_costmethod").toString() != "J")
-        {
-          QMessageBox::critical(this, tr("Insufficient Inventory"),
-                                  tr("<p>Item Number %1 in Site %2 is a Multiple Location or "
-                                     "Lot/Serial controlled Item which is short on Inventory. "
-                                     "This transaction cannot be completed as is. Please make "
-                                     "sure there is sufficient Quantity on Hand before proceeding.")
-                                .arg(issueSales.value("item_number").toString())
-                                .arg(issueSales.value("warehous_code").toString()));
-          return;
-        }
+        rollback.exec();
+        QMessageBox::information( this, tr("Issue to Shipping"), tr("Transaction Canceled") );
+        return;
       }
+    }
+    XSqlQuery commit("COMMIT;");
+  }
 
-      int       invhistid      = 0;
-      int       itemlocSeries  = 0;
-      XSqlQuery rollback;
-      rollback.prepare("ROLLBACK;");
+  // job items post production first, which needs its own distribution
+  XSqlQuery issueSales;
+  foreach (QVariant soitemid, jobids)
+  {
+    int       invhistid      = 0;
+    int       itemlocSeries  = 0;
+
+    issueSales.exec("BEGIN;"); // because of possible lot, serial, or location distribution cancelations
+    XSqlQuery prod;
+    prod.prepare("SELECT postSoItemProduction(:soitem_id, now()) AS result;");
+    prod.bindValue(":soitem_id", soitemid);
+    prod.exec();
+    if (prod.lastError().type() != QSqlError::NoError)
+    {
+      rollback.exec();
+      systemError(this, prod.lastError().databaseText(), __FILE__, __LINE__);
+      return;
+    }
+    if (prod.first())
+    {
+      itemlocSeries = prod.value("result").toInt();
 
-      issueSales.exec("BEGIN;"); // because of possible lot, serial, or location distribution cancelations
-      // If this is a lot/serial controlled job item, we need to post production first
-      if (job)
+      if (itemlocSeries < 0)
       {
-        XSqlQuery prod;
-        prod.prepare("SELECT postSoItemProduction(:soitem_id, now()) AS result;");
-        prod.bindValue(":soitem_id", _soitem->id());
-        prod.exec();
-        if (prod.lastError().type() != QSqlError::NoError)
-        {
-          rollback.exec();
-          systemError(this, prod.lastError().databaseText(), __FILE__, __LINE__);
-          return;
-        }
-        if (prod.first())
-        {
-          itemlocSeries = prod.value("result").toInt();
-
-          if (itemlocSeries < 0)
-          {
-            rollback.exec();
-                      systemError(this, storedProcErrorLookup("postProduction", itemlocSeries),
-                        __FILE__, __LINE__);
-            return;
-          }
-          else if (distributeInventory::SeriesAdjust(itemlocSeries, this) == XDialog::Rejected)
-          {
-            rollback.exec();
-            QMessageBox::information( this, tr("Issue to Shipping"), tr("Issue Canceled") );
-            return;
-          }
-
-          // Need to get the inventory history id so we can auto reverse the distribution when issuing
-          prod.prepare("SELECT invhist_id "
-                       "FROM invhist "
-                       "WHERE ((invhist_series = :itemlocseries) "
-                       " AND (invhist_transtype = 'RM')); ");
-          prod.bindValue(":itemlocseries", itemlocSeries);
-          prod.exec();
-          if (prod.lastError().type() != QSqlError::NoError)
-          {
-            rollback.exec();
-            systemError(this, prod.lastError().databaseText(), __FILE__, __LINE__);
-            return;
-          }
-          if (prod.first())
-            invhistid = prod.value("invhist_id").toInt();
-          else
-          {
-            rollback.exec();
-                      systemError(this, tr("Inventory history not found"),
-                        __FILE__, __LINE__);
-            return;
-          }
-        }
+        rollback.exec();
+        systemError(this, storedProcErrorLookup("postProduction", itemlocSeries),
+                    __FILE__, __LINE__);
+        return;
+      }
+      else if (distributeInventory::SeriesAdjust(itemlocSeries, this) == XDialog::Rejected)
+      {
+        rollback.exec();
+        QMessageBox::information( this, tr("Issue to Shipping"), tr("Issue Canceled") );
+        return;
       }
 
-      issueSales.prepare("SELECT issueLineBalanceToShipping('SO', :soitem_id, now(), :itemlocseries, :invhist_id) AS result;");
-      ;
-      issueSales.bindValue(":soitem_id", soitem->id());
-      if (invhistid)
-        issueSales.bindValue(":invhist_id", invhistid);
-      if (itemlocSeries)
-        issueSales.bindValue(":itemlocseries", itemlocSeries);
-      issueSales.exec();
-      if (issueSales.lastError().type() != QSqlError::NoError)
+      // Need to get the inventory history id so we can auto reverse the distribution when issuing
+      prod.prepare("SELECT invhist_id "
+                   "FROM invhist "
+                   "WHERE ((invhist_series = :itemlocseries) "
+                   " AND (invhist_transtype = 'RM')); ");
+      prod.bindValue(":itemlocseries", itemlocSeries);
+      prod.exec();
+      if (prod.lastError().type() != QSqlError::NoError)
       {
         rollback.exec();
-        systemError(this, issueSales.lastError().databaseText(), __FILE__, __LINE__);
+        systemError(this, prod.lastError().databaseText(), __FILE__, __LINE__);
         return;
       }
-      if (issueSales.first())
+      if (prod.first())
+        invhistid = prod.value("invhist_id").toInt();
+      else
       {
-        int result = issueSales.value("result").toInt();
-        if (result < 0)
-        {
-          rollback.exec();
-                      systemError(this, storedProcErrorLookup("issueLineBalanceToShipping", result) +
-                      tr("<br>Line Item %1").arg(selected[i]->text(0)),
-                      __FILE__, __LINE__);
-          return;
-        }
-
-        if (distributeInventory::SeriesAdjust(issueSales.value("result").toInt(), this) == XDialog::Rejected)
-        {
-          rollback.exec();
-          QMessageBox::information( this, tr("Issue to Shipping"), tr("Transaction Canceled") );
-          return;
-        }
+        rollback.exec();
+        systemError(this, tr("Inventory history not found"),
+                    __FILE__, __LINE__);
+        return;
+      }
+    }
 
-        issueSales.exec("COMMIT;");
+    issueSales.prepare("SELECT issueLineBalanceToShipping('SO', :soitem_id, now(), :itemlocseries, :invhist_id) AS result;");
+    issueSales.bindValue(":soitem_id", soitemid);
+    if (invhistid)
+      issueSales.bindValue(":invhist_id", invhistid);
+    if (itemlocSeries)
+      issueSales.bindValue(":itemlocseries", itemlocSeries);
+    issueSales.exec();
+    if (issueSales.first())
+    {
+      int result = issueSales.value("result").toInt();
+      if (result < 0)
+      {
+        rollback.exec();
+        systemError(this, storedProcErrorLookup("issueLineBalanceToShipping", result) +
+                    tr("<br>Line Item %1").arg(linenumbers.value(soitemid.toInt())),
+                    __FILE__, __LINE__);
+        return;
       }
-      else
+
+      if (distributeInventory::SeriesAdjust(result, this) == XDialog::Rejected)
       {
         rollback.exec();
-        systemError(this, tr("Line Item %1\n").arg(selected[i]->text(0)) +
-                    issueSales.lastError().databaseText(), __FILE__, __LINE__);
+        QMessageBox::information( this, tr("Issue to Shipping"), tr("Transaction Canceled") );
         return;
       }
+
+      issueSales.exec("COMMIT;");
+    }
+    else
+    {
+      rollback.exec();
+      systemError(this, tr("Line Item %1\n").arg(linenumbers.value(soitemid.toInt())) +
+                  issueSales.lastError().databaseText(), __FILE__, __LINE__);
+      return;
     }
   }
 
@@ -4462,63 +4543,60 @@ void salesOrder::sReserveStock()
 
 void salesOrder::sReserveLineBalance()
 {
-  XSqlQuery reserveSales;
-  reserveSales.prepare("SELECT reserveSoLineBalance(:soitem_id) AS result;");
-  QList<XTreeWidgetItem *> selected = _soitem->selectedItems();
-  for (int i = 0; i < selected.size(); i++)
-  {
-    reserveSales.bindValue(":soitem_id", ((XTreeWidgetItem *)(selected[i]))->id());
-    reserveSales.exec();
-    if (reserveSales.first())
-    {
-      int result = reserveSales.value("result").toInt();
-      if (result < 0)
-      {
-        systemError(this, storedProcErrorLookup("reserveSoLineBalance", result) +
-                    tr("<br>Line Item %1").arg(selected[i]->text(0)),
-                    __FILE__, __LINE__);
-        return;
-      }
-    }
-    else if (reserveSales.lastError().type() != QSqlError::NoError)
-    {
-      systemError(this, tr("Line Item %1\n").arg(selected[i]->text(0)) +
-                  reserveSales.lastError().databaseText(), __FILE__, __LINE__);
-      return;
-    }
-  }
-
-  sFillItemList();
+  updateLineReservations("reserveSoLineBalance");
 }
 
 void salesOrder::sUnreserveStock()
 {
-  XSqlQuery unreserveSales;
-  unreserveSales.prepare("SELECT unreserveSoLineQty(:soitem_id) AS result;");
+  updateLineReservations("unreserveSoLineQty");
+}
+
+/* run the reservation function on all of the selected lines with one
+   statement and report the lines it refused.
+ */
+void salesOrder::updateLineReservations(const QString &function)
+{
   QList<XTreeWidgetItem *> selected = _soitem->selectedItems();
+  QList<QVariant>          soitemids;
+  QHash<int, QString>      linenumbers;
   for (int i = 0; i < selected.size(); i++)
   {
-    unreserveSales.bindValue(":soitem_id", ((XTreeWidgetItem *)(selected[i]))->id());
-    unreserveSales.exec();
-    if (unreserveSales.first())
-    {
-      int result = unreserveSales.value("result").toInt();
-      if (result < 0)
-      {
-        systemError(this, storedProcErrorLookup("unreservedSoLineQty", result) +
-                    tr("<br>Line Item %1").arg(selected[i]->text(0)),
-                    __FILE__, __LINE__);
-        return;
-      }
-    }
-    else if (unreserveSales.lastError().type() != QSqlError::NoError)
-    {
-        systemError(this, tr("Line Item %1\n").arg(selected[i]->text(0)) +
-                  unreserveSales.lastError().databaseText(), __FILE__, __LINE__);
-      return;
-    }
+    soitemids.append(((XTreeWidgetItem *)(selected[i]))->id());
+    linenumbers.insert(((XTreeWidgetItem *)(selected[i]))->id(), selected[i]->text(0));
   }
-  
+  if (soitemids.isEmpty())
+    return;
+
+  ParameterList reservep;
+  reservep.append("soitem_id", QVariant(soitemids));
+  MetaSQLQuery reservem(QString("SELECT coitem_id, %1(coitem_id) AS result"
+                                "  FROM coitem"
+                                " WHERE (coitem_id IN ("
+                                "<? foreach('soitem_id') ?>"
+                                "  <? if not isfirst('soitem_id') ?>, <? endif ?>"
+                                "  <? value('soitem_id') ?>"
+                                "<? endforeach ?>"
+                                "))"
+                                " ORDER BY coitem_linenumber, coitem_subnumber;")
+                          .arg(function));
+  XSqlQuery reserveq = reservem.toQuery(reservep);
+  if (reserveq.lastError().type() != QSqlError::NoError)
+  {
+    systemError(this, reserveq.lastError().databaseText(), __FILE__, __LINE__);
+    return;
+  }
+
+  QStringList errors;
+  while (reserveq.next())
+  {
+    int result = reserveq.value("result").toInt();
+    if (result < 0)
+      errors << storedProcErrorLookup(function, result) +
+                tr("<br>Line Item %1").arg(linenumbers.value(reserveq.value("coitem_id").toInt()));
+  }
+  if (! errors.isEmpty())
+    systemError(this, errors.join("<br>"), __FILE__, __LINE__);
+
   sFillItemList();
 }
 
@@ -124,6 +124,7 @@ class salesOrder : public XWidget, public Ui::salesOrder
 
   private:
     bool    deleteForCancel();
+    void    updateLineReservations(const QString &function);
 
     bool    _saved;
     bool    _calcfreight;
@@ -21,6 +21,7 @@
 #include "guiErrorCheck.h"
 #include "jsHighlighter.h"
 #include "package.h"
+#include "scriptcache.h"
 #include "storedProcErrorLookup.h"
 
 #define DEBUG false
@@ -303,6 +304,8 @@ bool scriptEditor::sSaveToDB()
                            moveq, __FILE__, __LINE__);
   }
 
+  // after the move, which changes the schema the script is read from
+  ScriptCache::instance()->clear();
   setMode(cEdit);
   return true;
 }
@@ -15,7 +15,9 @@
 #include <QScriptEngine>
 #include <QScriptEngineDebugger>
 
+#include "scriptcache.h"
 #include "scripttoolbox.h"
+#include "xcomboboxcache.h"
 #include "../scriptapi/qeventproto.h"
 #include "../scriptapi/parameterlistsetup.h"
 
@@ -23,6 +25,8 @@ ScriptablePrivate::ScriptablePrivate(bool dialog, QWidget* parent)
   : _engine(0), _debugger(0), _scriptLoaded(false), _dialog(dialog), _parent(parent)
 {
   ScriptToolbox::setLastWindow(parent);
+  // each new window gets lookup lists as current as the database
+  XComboBoxCache::instance()->clear();
 }
 
 ScriptablePrivate::~ScriptablePrivate()
@@ -57,20 +61,17 @@ QScriptEngine *ScriptablePrivate::engine()
 void ScriptablePrivate::loadScript(const QString& oName)
 {
   qDebug() << "Looking for a script " << oName;
-  XSqlQuery scriptq;
-  scriptq.prepare("SELECT script_source, script_order"
-            "  FROM script"
-            " WHERE((script_name=:script_name)"
-            "   AND (script_enabled))"
-            " ORDER BY script_order;");
-  scriptq.bindValue(":script_name", oName);
-  scriptq.exec();
-  while(scriptq.next())
+  loadScripts(QStringList(oName));
+}
+
+void ScriptablePrivate::loadScripts(const QStringList &names)
+{
+  QList<ScriptCacheEntry> scripts = ScriptCache::instance()->scripts(names);
+  foreach (ScriptCacheEntry script, scripts)
   {
     if(engine())
     {
-      QString script = scriptHandleIncludes(scriptq.value("script_source").toString());
-      QScriptValue result = _engine->evaluate(script, _parent->objectName());
+      QScriptValue result = _engine->evaluate(script.source, _parent->objectName());
       if (_engine->hasUncaughtException())
       {
         int line = _engine->uncaughtExceptionLineNumber();
@@ -110,8 +111,7 @@ void ScriptablePrivate::loadScriptEngine()
   }
 
   scriptList.removeDuplicates();
-  for (int i = 0; i < scriptList.size(); ++i)
-    loadScript(scriptList.at(i));
+  loadScripts(scriptList);
 }
 
 enum SetResponse ScriptablePrivate::callSet(const ParameterList & params)
@@ -0,0 +1,122 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#include "scriptcache.h"
+
+#include <QApplication>
+#include <QSqlError>
+
+#include "includeresolver.h"
+#include "xsqlquery.h"
+#include "scripttoolbox.h"
+
+#define DEBUG false
+
+ScriptCache *ScriptCache::_instance = 0;
+
+ScriptCache *ScriptCache::instance()
+{
+  if (! _instance)
+    _instance = new ScriptCache(qApp);
+  return _instance;
+}
+
+ScriptCache::ScriptCache(QObject *parent)
+  : QObject(parent)
+{
+  setObjectName("ScriptCache");
+}
+
+ScriptCache::~ScriptCache()
+{
+  if (_instance == this)
+    _instance = 0;
+}
+
+/* return the enabled scripts for names, grouped in the order of names and
+   sorted by script_order within each name.
+ */
+QList<ScriptCacheEntry> ScriptCache::scripts(const QStringList &names)
+{
+  if (_loaded.isValid() && _loaded.elapsed() > maxAge * 1000)
+    clear();
+
+  QStringList missing;
+  foreach (QString name, names)
+  {
+    if (! _byName.contains(name) && ! missing.contains(name))
+      missing.append(name);
+  }
+
+  if (! missing.isEmpty())
+  {
+    QStringList placeholders;
+    for (int i = 0; i < missing.size(); i++)
+      placeholders.append(QString(":name%1").arg(i));
+
+    XSqlQuery scriptq;
+    scriptq.prepare("SELECT script_id, script_name, script_order, script_source"
+                    "  FROM script"
+                    " WHERE((script_name IN (" + placeholders.join(", ") + "))"
+                    "   AND (script_enabled))"
+                    " ORDER BY script_name, script_order;");
+    for (int i = 0; i < missing.size(); i++)
+      scriptq.bindValue(placeholders.at(i), missing.at(i));
+    scriptq.exec();
+
+    QHash<QString, QList<ScriptCacheEntry> > found;
+    while (scriptq.next())
+    {
+      ScriptCacheEntry entry;
+      entry.id     = scriptq.value("script_id").toInt();
+      entry.name   = scriptq.value("script_name").toString();
+      entry.order  = scriptq.value("script_order").toInt();
+      entry.source = scriptHandleIncludes(scriptq.value("script_source").toString());
+      found[entry.name].append(entry);
+    }
+
+    if (scriptq.lastError().type() != QSqlError::NoError)
+    {
+      qWarning("ScriptCache::scripts() could not load %s: %s",
+               qPrintable(missing.join(", ")),
+               qPrintable(scriptq.lastError().text()));
+      QList<ScriptCacheEntry> result;
+      foreach (QString name, names)
+        result.append(found.value(name));
+      return result;
+    }
+
+    if (_byName.isEmpty())
+      _loaded.start();
+
+    // names without scripts are cached too so they are not looked up again
+    foreach (QString name, missing)
+      _byName.insert(name, found.value(name));
+
+    if (DEBUG)
+      qDebug("ScriptCache::scripts() loaded %d names in one query",
+             missing.size());
+  }
+
+  QList<ScriptCacheEntry> result;
+  foreach (QString name, names)
+    result.append(_byName.value(name));
+  return result;
+}
+
+void ScriptCache::clear()
+{
+  if (DEBUG)
+    qDebug("ScriptCache::clear() dropping %d names", _byName.size());
+
+  _byName.clear();
+  _loaded = QTime();
+  IncludeResolver::instance()->clear();
+}
@@ -0,0 +1,64 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#ifndef __SCRIPTCACHE_H__
+#define __SCRIPTCACHE_H__
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+
+/* one enabled row of the script table, with #includes already expanded */
+class ScriptCacheEntry
+{
+  public:
+    int        id;
+    QString    name;
+    int        order;
+    QString    source;
+};
+
+/* Process-wide cache of the scripts windows load by name.
+
+   scripts() fetches every name it has not seen before in a single query
+   and remembers names without scripts too, so reopening a window soon
+   after costs no round trips. Nothing tells this client when another
+   one changes a script, so everything is dropped once it is maxAge
+   seconds old. clear() drops it immediately and is called after a
+   script or package is changed here.
+ */
+class ScriptCache : public QObject
+{
+  Q_OBJECT
+
+  public:
+    static ScriptCache *instance();
+
+    QList<ScriptCacheEntry> scripts(const QStringList &names);
+
+    static const int maxAge = 60;
+
+  public slots:
+    void clear();
+
+  private:
+    ScriptCache(QObject *parent = 0);
+    ~ScriptCache();
+
+    static ScriptCache *_instance;
+
+    QHash<QString, QList<ScriptCacheEntry> > _byName;
+    QTime                                    _loaded;  // when _byName was first filled
+};
+
+#endif
@@ -19,6 +19,7 @@
 
 #include "errorReporter.h"
 #include "guiclient.h"
+#include "scriptcache.h"
 #include "scriptEditor.h"
 
 scripts::scripts(QWidget* parent, const char* name, Qt::WindowFlags fl)
@@ -92,6 +93,7 @@ void scripts::sDelete()
                              delq, __FILE__, __LINE__))
       return;
 
+    ScriptCache::instance()->clear();
     sFillList();
   }
 }
@@ -24,6 +24,7 @@
 #include <QMessageBox>
 #include <QScriptEngine>
 #include <QScriptValueIterator>
+#include <QSqlDatabase>
 #include <QSqlError>
 #include <QStackedLayout>
 #include <QTabWidget>
@@ -38,10 +39,15 @@
 
 #include "creditCard.h"
 #include "creditcardprocessor.h"
+#include "errorReporter.h"
+#include "includeresolver.h"
+#include "metasqlcache.h"
 #include "mqlutil.h"
+#include "reportcache.h"
 #include "storedProcErrorLookup.h"
 #include "xdialog.h"
 #include "xmainwindow.h"
+#include "xsqlconnectionpool.h"
 #include "xtreewidget.h"
 #include "display.h"
 #include "xuiloader.h"
@@ -208,8 +214,7 @@ XSqlQuery ScriptToolbox::executeQuery(const QString & query, const ParameterList
 XSqlQuery ScriptToolbox::executeDbQuery(const QString & group, const QString & name)
 {
   ParameterList params;
-  MetaSQLQuery mql = mqlLoad(group, name);
-  return mql.toQuery(params);
+  return executeDbQuery(group, name, params);
 }
 
 /** @brief Execute a MetaSQL query loaded from the @c metasql table.
@@ -250,11 +255,107 @@ XSqlQuery ScriptToolbox::executeDbQuery(const QString & group, const QString & n
  */
 XSqlQuery ScriptToolbox::executeDbQuery(const QString & group, const QString & name, const ParameterList & params)
 {
-  MetaSQLQuery mql = mqlLoad(group, name);
-  return mql.toQuery(params);
+  QString errmsg;
+  bool    valid = false;
+  QSharedPointer<MetaSQLQuery> mql = MetaSQLCache::instance()->query(group, name, errmsg, &valid);
+  if (! valid)
+  {
+    ErrorReporter::error(QtCriticalMsg, _lastWindow, tr("Error Loading Query"),
+                         errmsg, __FILE__, __LINE__);
+    return XSqlQuery();
+  }
+  return mql->toQuery(params);
 }
 /** @example ccvoid.js */
 
+/** @brief Run a MetaSQL query on a background connection.
+
+  The query is parsed here but runs on one of the XSqlConnectionPool
+  connections, so the window stays responsive while it executes.
+  When it is done the toolbox emits queryFinished() with the serial
+  number returned here, the rows as an array of objects keyed by
+  column name, and an error message if the query failed.
+
+  The background connection is a separate database session and cannot
+  see uncommitted changes, so only use this for read-only queries.
+
+  @code
+    var serial = toolbox.executeQueryAsync("SELECT item_number FROM item;");
+    toolbox.queryFinished.connect(function(done, rows, error) {
+      if (done == serial && error == "")
+        print(rows.length);
+    });
+  @endcode
+
+  @param query  The MetaSQL query to parse and run
+  @param params Optional ParameterList controlling the MetaSQL parsing
+
+  @return A serial number to match against queryFinished(),
+          or 0 if the query could not be parsed
+ */
+qulonglong ScriptToolbox::executeQueryAsync(const QString & query, const ParameterList & params)
+{
+  MetaSQLQuery mql(query);
+  return executeAsync(mql, params);
+}
+
+/** @brief Run a MetaSQL query from the @c metasql table on a background
+           connection.
+
+  This is the asynchronous counterpart of executeDbQuery().
+  If the query cannot be loaded the error is reported and 0 is returned.
+
+  @see executeQueryAsync
+ */
+qulonglong ScriptToolbox::executeDbQueryAsync(const QString & group, const QString & name, const ParameterList & params)
+{
+  QString errmsg;
+  bool    valid = false;
+  QSharedPointer<MetaSQLQuery> mql = MetaSQLCache::instance()->query(group, name, errmsg, &valid);
+  if (! valid)
+  {
+    ErrorReporter::error(QtCriticalMsg, _lastWindow, tr("Error Loading Query"),
+                         errmsg, __FILE__, __LINE__);
+    return 0;
+  }
+  return executeAsync(*mql, params);
+}
+
+qulonglong ScriptToolbox::executeAsync(MetaSQLQuery &mql, const ParameterList &params)
+{
+  if (! mql.isValid())
+    return 0;
+
+  XSqlQuery xq = mql.toQuery(params, QSqlDatabase(), false);
+
+  XSqlConnectionPool *pool = XSqlConnectionPool::instance();
+  connect(pool, SIGNAL(queryFinished(qulonglong, QStringList, QVariantList, QString)),
+          this, SLOT(sQueryFinished(qulonglong, QStringList, QVariantList, QString)),
+          Qt::UniqueConnection);
+  qulonglong serial = pool->exec(xq.lastQuery(), xq.boundValues());
+  _asyncSerials.insert(serial);
+  return serial;
+}
+
+void ScriptToolbox::sQueryFinished(qulonglong serial, const QStringList &columns,
+                                   const QVariantList &rows, const QString &error)
+{
+  if (! _asyncSerials.remove(serial))
+    return;
+
+  QVariantList result;
+  foreach (QVariant row, rows)
+  {
+    QVariantList values = row.toList();
+    QVariantMap  record;
+    for (int i = 0; i < columns.size() && i < values.size(); i++)
+      record.insert(columns.at(i), values.at(i));
+    result.append(record);
+  }
+
+  emit queryFinished(serial, result, error);
+}
+
 /** @brief This is a convenience function that simply begins a database transaction.
  */
 XSqlQuery ScriptToolbox::executeBegin()
@@ -810,6 +911,19 @@ QWidget * ScriptToolbox::lastWindow() const
   return _lastWindow;
 }
 
+/* orReport(name, params) fetches and parses the definition every time;
+   share the parsed copy instead, which matters for scripts that print a
+   report per document in a loop.
+ */
+static void setCachedReport(orReport &report, const QString &name,
+                            const ParameterList &params)
+{
+  QDomDocument definition = ReportCache::instance()->definition(name);
+  if (! definition.isNull())
+    report.setDom(definition);
+  report.setParamList(params);
+}
+
 /** @brief Use the embedded OpenRPT to print a named report.
 
     Print the report using the given parameters, optionally saving the
@@ -824,7 +938,8 @@ QWidget * ScriptToolbox::lastWindow() const
  */
 bool ScriptToolbox::printReport(const QString & name, const ParameterList & params, const QString & pdfFilename)
 {
-  orReport report(name, params);
+  orReport report;
+  setCachedReport(report, name, params);
   if(report.isValid())
   {
       if(!pdfFilename.isEmpty())
@@ -858,7 +973,8 @@ bool ScriptToolbox::printReport(const QString & name, const ParameterList & para
  */
 bool ScriptToolbox::printReport(const QString & name, const ParameterList & params, const bool preview, QWidget *parent)
 {
-  orReport report(name, params);
+  orReport report;
+  setCachedReport(report, name, params);
   if (report.isValid())
     report.print(0, true, preview, parent);
   else
@@ -888,7 +1004,8 @@ bool ScriptToolbox::printReportCopies(const QString & name, const ParameterList
 {
   QPrinter printer(QPrinter::HighResolution);
 
-  orReport report(name, params);
+  orReport report;
+  setCachedReport(report, name, params);
   bool userCanceled = false;
   if (orReport::beginMultiPrint(&printer, userCanceled) == false)
   {
@@ -1570,54 +1687,7 @@ QObject *ScriptToolbox::getCreditCardProcessor()
  */
 QString scriptHandleIncludes(QString source)
 {
-  QString returnVal = source;
-  if (returnVal.contains(QRegExp("#include")))
-  {
-    QStringList line = returnVal.split(QRegExp("\n\r?|\r\n?"));
-    for (int i = 0; i < line.size(); i++)
-    {
-      if (line.at(i).startsWith("#include"))
-      {
-        QStringList words = line.at(i).split(QRegExp("\\s+"));
-        if (words.size() <= 1)
-          qWarning("scriptByName(%s): found #include with no script name",
-                   qPrintable(line.at(i)));
-
-        int order = -1;
-        if (words.size() > 2)
-          order = words.at(2).toInt();
-
-        QString name;
-        if (words.size() > 1)
-          name = words.at(1);
-
-        line.replace(i, "// " + line.at(i));
-        XSqlQuery inclq;
-        inclq.prepare("SELECT script_source "
-                      "FROM script "
-                      "WHERE ((script_name=:name)"
-                      "  AND  ((script_order=:order) OR (:order = -1))"
-                      "  AND  script_enabled) "
-                      "ORDER BY script_order;");
-        inclq.bindValue(":name",  name);
-        inclq.bindValue(":order", order);
-        inclq.exec();
-        bool found = false;
-        while (inclq.next())
-        {
-          found = true;
-          line.replace(i,
-                       line.at(i) + "\n" + scriptHandleIncludes(inclq.value("script_source").toString()));
-        }
-        if (found)
-          line.replace(i,
-                       line.at(i) + "\n// end include of " + name);
-      }
-    }
-    returnVal = line.join("\n");
-  }
-
-  return returnVal;
+  return IncludeResolver::instance()->expand(source);
 }
 
 /** @brief This is a wrapper around the core storedProcErrorLookup. */
@@ -12,6 +12,7 @@
 #define __SCRIPTTOOLBOX_H__
 
 #include <QObject>
+#include <QSet>
 #include <QVariant>
 #include <QtScript>
 
@@ -28,6 +29,7 @@ class QGridLayout;
 class QBoxLayout;
 class QStackedLayout;
 class QScriptEngine;
+class MetaSQLQuery;
 
 /* TODO: remove this enum and use AddressCluster::SaveFlags directly
    for some reason working with AddressCluster::SaveFlags failed but this works.
@@ -98,6 +100,8 @@ class ScriptToolbox : public QObject
     XSqlQuery executeQuery(const QString & query, const ParameterList & params);
     XSqlQuery executeDbQuery(const QString & group, const QString & name);
     XSqlQuery executeDbQuery(const QString & group, const QString & name, const ParameterList & params);
+    qulonglong executeQueryAsync(const QString & query, const ParameterList & params = ParameterList());
+    qulonglong executeDbQueryAsync(const QString & group, const QString & name, const ParameterList & params = ParameterList());
     XSqlQuery executeBegin();
     XSqlQuery executeCommit();
     XSqlQuery executeRollback();
@@ -202,8 +206,18 @@ class ScriptToolbox : public QObject
 
     QString storedProcErrorLookup(const QString proc, const int result);
 
+  signals:
+    void queryFinished(qulonglong serial, const QVariantList &rows, const QString &error);
+
+  private slots:
+    void sQueryFinished(qulonglong serial, const QStringList &columns,
+                        const QVariantList &rows, const QString &error);
+
   private:
+    qulonglong executeAsync(MetaSQLQuery &mql, const ParameterList &params);
+
     QScriptEngine * _engine;
+    QSet<qulonglong> _asyncSerials;
     static QWidget * _lastWindow;
 };
 
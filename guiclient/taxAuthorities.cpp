@@ -38,7 +38,7 @@ taxAuthorities::taxAuthorities(QWidget* parent, const char*, Qt::WindowFlags fl)
   parameterWidget()->append(tr("Postal Code Pattern"), "addr_postalcode_pattern", ParameterWidget::Text);
   parameterWidget()->append(tr("Country Pattern"), "addr_country_pattern", ParameterWidget::Text);
 
-  connect(omfgThis, SIGNAL(taxAuthsUpdated(int)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(taxAuthsUpdated(int)), this, SLOT(sScheduleFillList(int)));
 
   list()->addColumn(tr("Code"), 70, Qt::AlignLeft,   true,  "taxauth_code" );
   list()->addColumn(tr("Name"), -1, Qt::AlignLeft,   true,  "taxauth_name" );
@@ -1762,46 +1762,60 @@ void transferOrder::viewTransferOrder( int pId )
 
 void transferOrder::sReturnStock()
 {
-  XSqlQuery transferReturnStock;
+  QList<XTreeWidgetItem*> selected = _toitem->selectedItems();
+  QList<QVariant>         toitemids;
+  QHash<int, QString>     linenumbers;
+  for (int i = 0; i < selected.size(); i++)
+  {
+    toitemids.append(((XTreeWidgetItem*)(selected[i]))->id());
+    linenumbers.insert(((XTreeWidgetItem*)(selected[i]))->id(), selected[i]->text(0));
+  }
+  if (toitemids.isEmpty())
+    return;
+
   XSqlQuery rollback;
   rollback.prepare("ROLLBACK;");
 
-  transferReturnStock.exec("BEGIN;");	// because of possible lot, serial, or location distribution cancelations
-  transferReturnStock.prepare("SELECT returnItemShipments('TO', :toitem_id, 0, CURRENT_TIMESTAMP) AS result;");
-  QList<XTreeWidgetItem*> selected = _toitem->selectedItems();
-  for (int i = 0; i < selected.size(); i++)
+  XSqlQuery begin("BEGIN;");	// because of possible lot, serial, or location distribution cancelations
+  ParameterList returnp;
+  returnp.append("toitem_id", QVariant(toitemids));
+  MetaSQLQuery returnm("SELECT toitem_id,"
+                       "       returnItemShipments('TO', toitem_id, 0, CURRENT_TIMESTAMP) AS result"
+                       "  FROM toitem"
+                       " WHERE (toitem_id IN ("
+                       "<? foreach('toitem_id') ?>"
+                       "  <? if not isfirst('toitem_id') ?>, <? endif ?>"
+                       "  <? value('toitem_id') ?>"
+                       "<? endforeach ?>"
+                       "))"
+                       " ORDER BY toitem_linenumber;");
+  XSqlQuery transferReturnStock = returnm.toQuery(returnp);
+  if (transferReturnStock.lastError().type() != QSqlError::NoError)
   {
-    transferReturnStock.bindValue(":toitem_id", ((XTreeWidgetItem*)(selected[i]))->id());
-    transferReturnStock.exec();
-    if (transferReturnStock.first())
+    rollback.exec();
+    systemError(this, transferReturnStock.lastError().databaseText(), __FILE__, __LINE__);
+    return;
+  }
+  while (transferReturnStock.next())
+  {
+    int result = transferReturnStock.value("result").toInt();
+    if (result < 0)
     {
-      int result = transferReturnStock.value("result").toInt();
-      if (result < 0)
-      {
-        rollback.exec();
-        systemError(this, storedProcErrorLookup("returnItemShipments", result) +
-                          tr("<br>Line Item %1").arg(selected[i]->text(0)),
-                           __FILE__, __LINE__);
-        return;
-      }
-      if (distributeInventory::SeriesAdjust(transferReturnStock.value("result").toInt(), this) == XDialog::Rejected)
-      {
-        rollback.exec();
-        QMessageBox::information( this, tr("Return Stock"), tr("Transaction Canceled") );
-        return;
-      }
-
+      rollback.exec();
+      systemError(this, storedProcErrorLookup("returnItemShipments", result) +
+                        tr("<br>Line Item %1").arg(linenumbers.value(transferReturnStock.value("toitem_id").toInt())),
+                         __FILE__, __LINE__);
+      return;
     }
-    else if (transferReturnStock.lastError().type() != QSqlError::NoError)
+    if (distributeInventory::SeriesAdjust(result, this) == XDialog::Rejected)
     {
       rollback.exec();
-      systemError(this, tr("Line Item %1\n").arg(selected[i]->text(0)) +
-                        transferReturnStock.lastError().databaseText(), __FILE__, __LINE__);
+      QMessageBox::information( this, tr("Return Stock"), tr("Transaction Canceled") );
       return;
     }
   }
 
-  transferReturnStock.exec("COMMIT;");
+  XSqlQuery commit("COMMIT;");
 
   sFillItemList();
 }
@@ -1835,85 +1849,143 @@ void transferOrder::sIssueStock()
 
 void transferOrder::sIssueLineBalance()
 {
-  XSqlQuery transferIssueLineBalance;
   QList<XTreeWidgetItem*> selected = _toitem->selectedItems();
+  QList<QVariant>         toitemids;
+  QHash<int, QString>     linenumbers;
   for (int i = 0; i < selected.size(); i++)
   {
     XTreeWidgetItem* toitem = (XTreeWidgetItem*)(selected[i]);
     // skip if status = C or X or U
     if (toitem->altId() != 1 && toitem->altId() != 4 && toitem->altId() != 5)
     {
+      toitemids.append(toitem->id());
+      linenumbers.insert(toitem->id(), toitem->text(0));
+    }
+  }
+  if (toitemids.isEmpty())
+    return;
 
-      if(_requireInventory->isChecked())
-      {
-        transferIssueLineBalance.prepare("SELECT sufficientInventoryToShipItem('TO', :toitem_id) AS result;");
-        transferIssueLineBalance.bindValue(":toitem_id", toitem->id());
-        transferIssueLineBalance.exec();
-        if (transferIssueLineBalance.first())
-        {
-          int result = transferIssueLineBalance.value("result").toInt();
-          if (result < 0)
-          {
-            transferIssueLineBalance.prepare("SELECT item_number, tohead_srcname "
-                "  FROM toitem, tohead, item "
-                " WHERE ((toitem_item_id=item_id)"
-                "   AND  (toitem_tohead_id=tohead_id)"
-                "   AND  (toitem_id=:toitem_id)); ");
-            transferIssueLineBalance.bindValue(":toitem_id", toitem->id());
-            transferIssueLineBalance.exec();
-            if (! transferIssueLineBalance.first() && transferIssueLineBalance.lastError().type() != QSqlError::NoError)
-            {
-              ErrorReporter::error(QtCriticalMsg, this, tr("Error Getting Item"),
-                                   transferIssueLineBalance, __FILE__, __LINE__);
-              systemError(this,
-                storedProcErrorLookup("sufficientInventoryToShipItem",
-                          result)
-                .arg(transferIssueLineBalance.value("item_number").toString())
-                .arg(transferIssueLineBalance.value("tohead_srcname").toString()), __FILE__, __LINE__);
-              return;
-            }
-          }
-        }
-        else if (ErrorReporter::error(QtCriticalMsg, this, tr("Error Checking Inventory"),
-                               transferIssueLineBalance, __FILE__, __LINE__))
-          return;
-      }
+  ParameterList checkp;
+  checkp.append("toitem_id", QVariant(toitemids));
+  if(_requireInventory->isChecked())
+    checkp.append("requireInventory");
+
+  // check all of the lines in one round trip before issuing any of them.
+  // sufficientInventoryToShipItem only sees one line, so also compare the
+  // balance of all selected lines for the same source itemsite with what
+  // is on hand
+  MetaSQLQuery checkm("SELECT toitem_id, item_number, tohead_srcname, isdistributed,"
+                      "<? if exists('requireInventory') ?>"
+                      "       CASE WHEN (result >= 0 AND iscontrolled"
+                      "                  AND qtyonhand < SUM(needed) OVER (PARTITION BY itemsite_id)) THEN -1"
+                      "            ELSE result"
+                      "       END AS result"
+                      "<? else ?>"
+                      "       0 AS result"
+                      "<? endif ?>"
+                      "  FROM (SELECT toitem_id, toitem_linenumber, item_number, tohead_srcname, itemsite_id,"
+                      "<? if exists('requireInventory') ?>"
+                      "               sufficientInventoryToShipItem('TO', toitem_id) AS result,"
+                      "<? endif ?>"
+                      "               NOT ((item_type = 'R') OR (itemsite_controlmethod = 'N')) AS iscontrolled,"
+                      "               (NOT ((item_type = 'R') OR (itemsite_controlmethod = 'N'))"
+                      "                AND ((itemsite_controlmethod IN ('L', 'S')) OR (itemsite_loccntrl))) AS isdistributed,"
+                      "               itemsite_qtyonhand AS qtyonhand,"
+                      "               noNeg(toitem_qty_ordered - toitem_qty_shipped -"
+                      "                     qtyAtShipping('TO', toitem_id)) AS needed"
+                      "          FROM toitem"
+                      "          JOIN tohead ON (toitem_tohead_id=tohead_id)"
+                      "          JOIN item ON (toitem_item_id=item_id)"
+                      "          JOIN itemsite ON ((itemsite_item_id=toitem_item_id)"
+                      "                        AND (itemsite_warehous_id=tohead_src_warehous_id))"
+                      "         WHERE (toitem_id IN ("
+                      "<? foreach('toitem_id') ?>"
+                      "  <? if not isfirst('toitem_id') ?>, <? endif ?>"
+                      "  <? value('toitem_id') ?>"
+                      "<? endforeach ?>"
+                      "))) AS line"
+                      " ORDER BY toitem_linenumber;");
+  XSqlQuery checkq = checkm.toQuery(checkp);
+  if (ErrorReporter::error(QtCriticalMsg, this, tr("Error Checking Inventory"),
+                           checkq, __FILE__, __LINE__))
+    return;
 
-      XSqlQuery rollback;
-      rollback.prepare("ROLLBACK;");
+  QList<QVariant> issueids;       // need no distribution, issued together
+  QList<QVariant> distributeids;  // may need distribution, issued one by one
+  while (checkq.next())
+  {
+    int result = checkq.value("result").toInt();
+    if (result < 0)
+    {
+      systemError(this,
+        storedProcErrorLookup("sufficientInventoryToShipItem", result)
+        .arg(checkq.value("item_number").toString())
+        .arg(checkq.value("tohead_srcname").toString()), __FILE__, __LINE__);
+      return;
+    }
+    if (checkq.value("isdistributed").toBool())
+      distributeids.append(checkq.value("toitem_id"));
+    else
+      issueids.append(checkq.value("toitem_id"));
+  }
 
-      transferIssueLineBalance.exec("BEGIN;");	// because of possible lot, serial, or location distribution cancelations
-      transferIssueLineBalance.prepare("SELECT issueLineBalanceToShipping('TO', :toitem_id, CURRENT_TIMESTAMP) AS result;");
-      transferIssueLineBalance.bindValue(":toitem_id", toitem->id());
-      transferIssueLineBalance.exec();
-      if (transferIssueLineBalance.first())
-      {
-        int result = transferIssueLineBalance.value("result").toInt();
-        if (result < 0)
-        {
-          rollback.exec();
-          systemError(this, storedProcErrorLookup("issueLineBalance", result) +
-                            tr("<br>Line Item %1").arg(selected[i]->text(0)),
-                      __FILE__, __LINE__);
-          return;
-        }
-        if (distributeInventory::SeriesAdjust(transferIssueLineBalance.value("result").toInt(), this) == XDialog::Rejected)
-        {
-          rollback.exec();
-          QMessageBox::information( this, tr("Issue to Shipping"), tr("Transaction Canceled") );
-          return;
-        }
+  XSqlQuery rollback;
+  rollback.prepare("ROLLBACK;");
 
-        transferIssueLineBalance.exec("COMMIT;");
+  /* lines that need no distribution can't be canceled half way, so they
+     are issued together in one transaction. lines that may need lot,
+     serial, or location distribution each get their own, so canceling
+     one distribution only rolls back that line, as it always has.
+   */
+  QList<QList<QVariant> > transactions;
+  if (! issueids.isEmpty())
+    transactions.append(issueids);
+  foreach (QVariant toitemid, distributeids)
+    transactions.append(QList<QVariant>() << toitemid);
+
+  foreach (QList<QVariant> transactionids, transactions)
+  {
+    ParameterList issuep;
+    issuep.append("toitem_id", QVariant(transactionids));
+
+    XSqlQuery begin("BEGIN;");	// because of possible lot, serial, or location distribution cancelations
+    MetaSQLQuery issuem("SELECT toitem_id,"
+                        "       issueLineBalanceToShipping('TO', toitem_id, CURRENT_TIMESTAMP) AS result"
+                        "  FROM toitem"
+                        " WHERE (toitem_id IN ("
+                        "<? foreach('toitem_id') ?>"
+                        "  <? if not isfirst('toitem_id') ?>, <? endif ?>"
+                        "  <? value('toitem_id') ?>"
+                        "<? endforeach ?>"
+                        "))"
+                        " ORDER BY toitem_linenumber;");
+    XSqlQuery transferIssueLineBalance = issuem.toQuery(issuep);
+    if (transferIssueLineBalance.lastError().type() != QSqlError::NoError)
+    {
+      rollback.exec();
+      systemError(this, transferIssueLineBalance.lastError().databaseText(), __FILE__, __LINE__);
+      return;
+    }
+    while (transferIssueLineBalance.next())
+    {
+      int result = transferIssueLineBalance.value("result").toInt();
+      if (result < 0)
+      {
+        rollback.exec();
+        systemError(this, storedProcErrorLookup("issueLineBalance", result) +
+                          tr("<br>Line Item %1").arg(linenumbers.value(transferIssueLineBalance.value("toitem_id").toInt())),
+                    __FILE__, __LINE__);
+        return;
       }
-      else
+      if (distributeInventory::SeriesAdjust(result, this) == XDialog::Rejected)
       {
         rollback.exec();
-        systemError(this, tr("Line Item %1\n").arg(selected[i]->text(0)) +
-                          transferIssueLineBalance.lastError().databaseText(), __FILE__, __LINE__);
+        QMessageBox::information( this, tr("Issue to Shipping"), tr("Transaction Canceled") );
         return;
       }
     }
+
+    XSqlQuery commit("COMMIT;");
   }
 
   sFillItemList();
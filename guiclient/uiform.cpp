@@ -23,6 +23,7 @@
 
 #include "customCommand.h"
 #include "package.h"
+#include "scriptcache.h"
 #include "scriptEditor.h"
 #include "storedProcErrorLookup.h"
 #include "xTupleDesigner.h"
@@ -438,6 +439,7 @@ void uiform::sScriptDelete()
                "WHERE (script_id=:script_id);" );
     uiformScriptDelete.bindValue(":script_id", _script->id());
     uiformScriptDelete.exec();
+    ScriptCache::instance()->clear();
   }
 
   sFillList();
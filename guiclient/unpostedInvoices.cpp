@@ -69,7 +69,7 @@ unpostedInvoices::unpostedInvoices(QWidget* parent, const char* name, Qt::Window
   if (_preferences->boolean("XCheckBox/forgetful"))
     _printJournal->setChecked(true);
 
-  connect(omfgThis, SIGNAL(invoicesUpdated(int, bool)), this, SLOT(sFillList()));
+  connect(omfgThis, SIGNAL(invoicesUpdated(int, bool)), this, SLOT(sScheduleFillList(int)));
 
   sFillList();
 }
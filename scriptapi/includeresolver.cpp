@@ -0,0 +1,190 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#include "includeresolver.h"
+
+#include <QApplication>
+#include <QRegExp>
+#include <QSqlError>
+
+#include <xsqlquery.h>
+
+#define DEBUG false
+
+// characters of expanded #include text to keep
+#define MAXEXPANDED (4 * 1024 * 1024)
+
+IncludeResolver *IncludeResolver::_instance = 0;
+
+IncludeResolver *IncludeResolver::instance()
+{
+  if (! _instance)
+    _instance = new IncludeResolver(qApp);
+  return _instance;
+}
+
+IncludeResolver::IncludeResolver(QObject *parent)
+  : QObject(parent),
+    _expanded(MAXEXPANDED)
+{
+  setObjectName("IncludeResolver");
+}
+
+IncludeResolver::~IncludeResolver()
+{
+  if (_instance == this)
+    _instance = 0;
+}
+
+/* read every enabled script at once, again if the last read is more than
+   maxAge seconds old. expiry is only checked outside of an expansion so
+   nested #includes see the same scripts. a failed query leaves the
+   resolver empty but unloaded so the next request tries again.
+ */
+bool IncludeResolver::load()
+{
+  if (_loaded.isValid())
+  {
+    if (! _expanding.isEmpty() || _loaded.elapsed() < maxAge * 1000)
+      return true;
+    clear();
+  }
+
+  XSqlQuery scriptq;
+  scriptq.exec("SELECT script_id, script_name, script_order, script_source"
+               "  FROM script"
+               " WHERE script_enabled"
+               " ORDER BY script_name, script_order;");
+  if (scriptq.lastError().type() != QSqlError::NoError)
+  {
+    qWarning("IncludeResolver::load() could not read scripts: %s",
+             qPrintable(scriptq.lastError().text()));
+    _scripts.clear();
+    return false;
+  }
+
+  while (scriptq.next())
+  {
+    IncludeResolverScript script;
+    script.id     = scriptq.value("script_id").toInt();
+    script.order  = scriptq.value("script_order").toInt();
+    script.source = scriptq.value("script_source").toString();
+    _scripts[scriptq.value("script_name").toString()].append(script);
+  }
+
+  if (DEBUG)
+    qDebug("IncludeResolver::load() read %d script names", _scripts.size());
+
+  _loaded.start();
+  return true;
+}
+
+/* replace each line of the form
+     #include name [order]
+   with a comment and the expanded source of the named script(s).
+ */
+QString IncludeResolver::expand(const QString &source)
+{
+  if (! source.contains("#include"))
+    return source;
+
+  load();
+
+  QStringList line = source.split(QRegExp("\n\r?|\r\n?"));
+  for (int i = 0; i < line.size(); i++)
+  {
+    if (line.at(i).startsWith("#include"))
+    {
+      QStringList words = line.at(i).split(QRegExp("\\s+"));
+      if (words.size() <= 1)
+        qWarning("scriptByName(%s): found #include with no script name",
+                 qPrintable(line.at(i)));
+
+      int order = -1;
+      if (words.size() > 2)
+        order = words.at(2).toInt();
+
+      QString name;
+      if (words.size() > 1)
+        name = words.at(1);
+
+      line.replace(i, "// " + line.at(i) + expandInclude(name, order));
+    }
+  }
+
+  return line.join("\n");
+}
+
+/* return what follows the commented-out #include line: the expanded
+   scripts and an end marker, or nothing if no script matched.
+ */
+QString IncludeResolver::expandInclude(const QString &name, int order)
+{
+  QString key = QString("%1:%2").arg(name).arg(order);
+  QString *cached = _expanded.object(key);
+  if (cached)
+    return *cached;
+
+  if (_expanding.contains(key))
+  {
+    qWarning("IncludeResolver::expand() skipping cyclic #include: %s -> %s",
+             qPrintable(_expanding.join(" -> ")), qPrintable(key));
+    return QString("\n// cyclic include of %1 skipped").arg(name);
+  }
+
+  _expanding.append(key);
+
+  QString result;
+  bool found = false;
+  foreach (IncludeResolverScript script, _scripts.value(name))
+  {
+    if (order != -1 && script.order != order)
+      continue;
+    found = true;
+    result += "\n" + expand(script.source);
+  }
+  if (found)
+    result += "\n// end include of " + name;
+
+  _expanding.removeLast();
+  // an expansion bigger than the whole cache is simply not kept
+  _expanded.insert(key, new QString(result), qMax(1, result.size()));
+  return result;
+}
+
+/* return the scripts include(name) should run, in script_order,
+   compiling each one the first time it is asked for.
+ */
+QList<IncludeResolverScript> IncludeResolver::scripts(const QString &name)
+{
+  load();
+
+  QHash<QString, QList<IncludeResolverScript> >::iterator it = _scripts.find(name);
+  if (it == _scripts.end())
+    return QList<IncludeResolverScript>();
+
+  for (int i = 0; i < it.value().size(); i++)
+  {
+    IncludeResolverScript &script = it.value()[i];
+    if (script.program.isNull())
+      script.program = QScriptProgram(script.source, name);
+  }
+  return it.value();
+}
+
+void IncludeResolver::clear()
+{
+  if (DEBUG)
+    qDebug("IncludeResolver::clear() dropping %d script names", _scripts.size());
+
+  _scripts.clear();
+  _expanded.clear();
+  _loaded = QTime();
+}
@@ -0,0 +1,77 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#ifndef __INCLUDERESOLVER_H__
+#define __INCLUDERESOLVER_H__
+
+#include <QCache>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QScriptProgram>
+#include <QString>
+#include <QStringList>
+#include <QTime>
+
+/* one enabled row of the script table, exactly as stored */
+class IncludeResolverScript
+{
+  public:
+    int            id;
+    int            order;
+    QString        source;
+    QScriptProgram program;  // compiled on first include()
+};
+
+/* Process-wide resolver for #include lines and the include() function.
+
+   The first request loads every enabled script in one query. expand()
+   then replaces #include lines from memory and remembers the expansion
+   of each (name, order) pair, so a library included by many windows is
+   expanded only once. Include cycles are reported and cut instead of
+   recursing forever. scripts() hands include() the compiled scripts
+   for a name so they are not fetched and parsed again for each window.
+
+   Expansions are kept in a QCache limited by total text size. Nothing
+   tells this client when another one changes a script, so everything is
+   reloaded once it is maxAge seconds old. ScriptCache::clear() drops it
+   immediately after a script or package is changed in this client.
+ */
+class IncludeResolver : public QObject
+{
+  Q_OBJECT
+
+  public:
+    static IncludeResolver *instance();
+
+    QString                      expand(const QString &source);
+    QList<IncludeResolverScript> scripts(const QString &name);
+
+    static const int maxAge = 60;
+
+  public slots:
+    void clear();
+
+  private:
+    IncludeResolver(QObject *parent = 0);
+    ~IncludeResolver();
+
+    bool    load();
+    QString expandInclude(const QString &name, int order);
+
+    static IncludeResolver *_instance;
+
+    QTime                                         _loaded;    // invalid until load() succeeds
+    QHash<QString, QList<IncludeResolverScript> > _scripts;   // by script_name
+    QCache<QString, QString>                      _expanded;  // <name:order, text>
+    QStringList                                   _expanding; // name:order stack
+};
+
+#endif
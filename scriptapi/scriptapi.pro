@@ -21,6 +21,7 @@ UI_DIR = tmp
 
 HEADERS += setupscriptapi.h \
     include.h \
+    includeresolver.h \
     scriptapi_internal.h \
     metasqlhighlighterproto.h \
     orreportproto.h \
@@ -122,6 +123,7 @@ HEADERS += setupscriptapi.h \
 
 SOURCES += setupscriptapi.cpp \
     include.cpp \
+    includeresolver.cpp \
     metasqlhighlighterproto.cpp \
     orreportproto.cpp \
     parameterlistsetup.cpp \
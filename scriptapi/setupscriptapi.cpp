@@ -8,6 +8,9 @@
  * to be bound by its terms.
  */
 
+#include <QScriptContext>
+#include <QScriptEngine>
+
 #include "addressclustersetup.h"
 #include "alarmssetup.h"
 #include "calendarTools.h"
@@ -120,6 +123,8 @@
 #include "xtreewidget.h"
 #include "xvariantsetup.h"
 
+#define DEBUG false
+
 /*! \defgroup scriptapi The xTuple ERP Scripting API
 
   The xTuple ERP Scripting API defines the interface between extension %scripts
@@ -127,37 +132,102 @@
 
  */
 
+/* These setup functions do nothing but create one constant global object,
+   so they can wait until a script first uses that name. Setups that
+   register prototypes or metatypes stay eager because C++ code hands
+   values of those types to scripts without going through the global.
+ */
+typedef void (*ScriptApiSetup)(QScriptEngine *);
+
+struct LazyScriptApi
+{
+  const char     *name;
+  ScriptApiSetup  setup;
+};
+
+static const LazyScriptApi lazyScriptApi[] = {
+  { "AddressCluster",          setupAddressCluster },
+  { "Alarms",                  setupAlarms },
+  { "CRMAcctLineEdit",         setupCRMAcctLineEdit },
+  { "Comments",                setupComments },
+  { "ContactWidget",           setupContactWidget },
+  { "CurrDisplay",             setupCurrDisplay },
+  { "Documents",               setupDocuments },
+  { "ExportHelper",            setupExportHelper },
+  { "GLCluster",               setupGLCluster },
+  { "include",                 setupInclude },
+  { "ParameterGroup",          setupParameterGroup },
+  { "ProjectLineEdit",         setupProjectLineEdit },
+  { "QDialog",                 setupQDialog },
+  { "QSizePolicy",             setupQSizePolicy },
+  { "RaLineEdit",              setupRaLineEdit },
+  { "RevisionLineEdit",        setupRevisionLineEdit },
+  { "Screen",                  setupScreen },
+  { "ShipmentClusterLineEdit", setupShipmentClusterLineEdit },
+  { "VendorGroup",             setupVendorGroup },
+  { "WComboBox",               setupWComboBox },
+  { "WoLineEdit",              setupWoCluster },
+  { "WomatlCluster",           setupWomatlCluster },
+  { "XDateEdit",               setupXDateEdit },
+  { "Xt",                      setupXt },
+  { "XVariant",                setupXVariant },
+};
+
+/* getter and setter for a lazy global: replace the accessor with the real
+   value, then apply an assignment only if that value is writable.
+ */
+static QScriptValue lazyScriptApiAccessor(QScriptContext *context, QScriptEngine *engine)
+{
+  int idx = context->callee().data().toInt32();
+  QScriptValue global = engine->globalObject();
+
+  global.setProperty(lazyScriptApi[idx].name, QScriptValue());
+  lazyScriptApi[idx].setup(engine);
+
+  if (DEBUG)
+    qDebug("lazyScriptApiAccessor() set up %s on first use",
+           lazyScriptApi[idx].name);
+
+  if (context->argumentCount() > 0 &&
+      ! (global.propertyFlags(lazyScriptApi[idx].name) & QScriptValue::ReadOnly))
+    global.setProperty(lazyScriptApi[idx].name, context->argument(0));
+
+  return global.property(lazyScriptApi[idx].name);
+}
+
+static void setupLazyScriptApi(QScriptEngine *engine)
+{
+  QScriptValue global = engine->globalObject();
+  int count = sizeof(lazyScriptApi) / sizeof(lazyScriptApi[0]);
+  for (int i = 0; i < count; i++)
+  {
+    QScriptValue accessor = engine->newFunction(lazyScriptApiAccessor);
+    accessor.setData(QScriptValue(engine, i));
+    global.setProperty(lazyScriptApi[i].name, accessor,
+                       QScriptValue::PropertyGetter | QScriptValue::PropertySetter);
+  }
+}
+
 void setupScriptApi(QScriptEngine *engine)
 {
-  setupAddressCluster(engine);
-  setupAlarms(engine);
+  setupLazyScriptApi(engine);
+
   setupCLineEdit(engine);
-  setupCRMAcctLineEdit(engine);
-  setupComments(engine);
-  setupContactWidget(engine);
-  setupCurrDisplay(engine);
-  setupDocuments(engine);
   setupEmpCluster(engine);
   setupEmpClusterLineEdit(engine);
-  setupExportHelper(engine);
   setupFileMoveSelector(engine);
-  setupGLCluster(engine);
-  setupInclude(engine);
   setupItemLineEdit(engine);
   setupMetaSQLHighlighterProto(engine);
   setupOrderLineEdit(engine);
   setupOrReportProto(engine);
   setupParameterEditProto(engine);
-  setupParameterGroup(engine);
   setupParameterList(engine);
   setupParameterWidget(engine);
   setupPeriodListViewItem(engine);
-  setupProjectLineEdit(engine);
   setupQActionProto(engine);
   setupQApplicationProto(engine);
   setupQBoxLayoutProto(engine);
   setupQByteArrayProto(engine);
-  setupQDialog(engine);
   setupQDialogButtonBoxProto(engine);
   setupQDirProto(engine);
   setupQDockWidgetProto(engine);
@@ -201,7 +271,6 @@ void setupScriptApi(QScriptEngine *engine)
   setupQProcessProto(engine);
   setupQProcessEnvironmentProto(engine);
   setupQPushButtonProto(engine);
-  setupQSizePolicy(engine);
   setupQSpacerItem(engine);
   setupQSqlDatabaseProto(engine);
   setupQSqlErrorProto(engine);
@@ -221,26 +290,15 @@ void setupScriptApi(QScriptEngine *engine)
   setupQWebPageProto(engine);
   setupQWebViewProto(engine);
   setupQWidgetProto(engine);
-  setupRaLineEdit(engine);
   setupRecurrenceWidget(engine);
-  setupRevisionLineEdit(engine);
-  setupScreen(engine);
-  setupShipmentClusterLineEdit(engine);
   setupUsernameCluster(engine);
   setupUsernameLineEdit(engine);
-  setupVendorGroup(engine);
-  setupWComboBox(engine);
-  setupWoCluster(engine);
-  setupWomatlCluster(engine);
   setupXCheckBox(engine);
   setupXComboBox(engine);
   setupXDataWidgetMapperProto(engine);
-  setupXDateEdit(engine);
   setupXDocCopySetter(engine);
   setupXSqlTableModelProto(engine);
   setupXSqlQueryProto(engine);
-  setupXt(engine);
   setupXTreeWidget(engine);
   setupXTreeWidgetItem(engine);
-  setupXVariant(engine);
 }
@@ -434,7 +434,7 @@ void ItemLineEdit::silentSetId(const int pId)
     if (completer())
     {
       disconnect(this, SIGNAL(textChanged(QString)), this, SLOT(sHandleCompleter()));
-      static_cast<QSqlQueryModel* >(completer()->model())->setQuery(QSqlQuery());
+      clearCompleter();
     }
 
     _itemNumber = item.value("item_number").toString();
@@ -550,77 +550,35 @@ void ItemLineEdit::sCopy()
   return;
 }
 
-void ItemLineEdit::sHandleCompleter()
+QString ItemLineEdit::completerQuery(const QString &prefix, QVariantMap &bindings)
 {
-  if (DEBUG) qDebug("%s::sHandleCompleter() entered", qPrintable(objectName()));
-  if (!hasFocus())
-    return;
+  if (DEBUG) qDebug("%s::completerQuery(%s) entered", qPrintable(objectName()), qPrintable(prefix));
 
-  QString stripped = text().trimmed().toUpper();
-  if (stripped.isEmpty())
-    return;
-
-  int width = 0;
-  QSqlQueryModel* model = static_cast<QSqlQueryModel *>(_completer->model());
-  QTreeView * view = static_cast<QTreeView *>(_completer->popup());
-  _parsed = true;
-  XSqlQuery numQ;
+  // item_number and item_upccode are compared as stored, in upper case
+  bindings.insert(":prefix", likePrefix(prefix.toUpper()));
 
   if (_useQuery)
-  {
-    numQ.prepare(QString("SELECT *"
-                         "  FROM (%1) data"
-                         " WHERE (POSITION(:number IN item_number)=1)"
-                         " LIMIT 10")
-                 .arg(QString(_sql)).remove(";"));
-    numQ.bindValue(":number", stripped);
-  }
-  else
-  {
-    QString pre( "SELECT DISTINCT item_id, item_number, "
-                 "(item_descrip1 || ' ' || item_descrip2) AS itemdescrip, "
-                 "item_upccode AS description " );
-
-    QStringList clauses;
-    clauses = _extraClauses;
-    clauses << "((POSITION(:searchString IN item_number) = 1)"
-            " OR (POSITION(:searchString IN item_upccode) = 1))";
-    numQ.prepare(buildItemLineEditQuery(pre, clauses, QString::null, _type, true)
-                              .replace(";"," ORDER BY item_number LIMIT 10;"));
-    numQ.bindValue(":searchString", QString(text().trimmed().toUpper()));
-  }
-
-  numQ.exec();
-  if (numQ.first())
-  {
-    int numberCol = numQ.record().indexOf("item_number");
-    int descripCol = numQ.record().indexOf("itemdescrip");
-    model->setQuery(numQ);
-    _completer->setCompletionPrefix(stripped);
-    for (int i = 0; i < model->columnCount(); i++)
-    {
-      if ( (i == numberCol) ||
-           (i == descripCol) )
-      {
-        view->resizeColumnToContents(i);
-        width += view->columnWidth(i);
-      }
-      else
-        view->hideColumn(i);
-    }
-  }
-  else
-    model->setQuery(QSqlQuery());
-
-  if (width > 350)
-    width = 350;
+    return QString("SELECT *"
+                   "  FROM (%1) data"
+                   " WHERE (item_number LIKE :prefix)"
+                   " ORDER BY item_number")
+           .arg(QString(_sql).remove(";"));
+
+  QString pre( "SELECT DISTINCT item_id, item_number, "
+               "(item_descrip1 || ' ' || item_descrip2) AS itemdescrip, "
+               "item_upccode AS description " );
+
+  QStringList clauses;
+  clauses = _extraClauses;
+  clauses << "((item_number LIKE :prefix)"
+          " OR (item_upccode LIKE :prefix))";
+  return buildItemLineEditQuery(pre, clauses, QString::null, _type, true)
+           .replace(";", " ORDER BY item_number");
+}
 
-  QRect rect;
-  rect.setHeight(height());
-  rect.setWidth(width);
-  rect.setBottomLeft(QPoint(0, height() - 2));
-  _completer->complete(rect);
-  _parsed = false;
+QStringList ItemLineEdit::completerColumns() const
+{
+  return QStringList() << "item_number" << "itemdescrip";
 }
 
 void ItemLineEdit::sUpdateMenu()
@@ -678,7 +636,7 @@ void ItemLineEdit::sSearch(ParameterList params)
   itemSearch* newdlg = searchFactory();
   newdlg->set(params);
 
-  QString stripped = text().trimmed();
+  QString stripped = text().trimmed().toUpper();
   if(stripped.length())
   {
     XSqlQuery numQ;
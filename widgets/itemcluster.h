@@ -164,7 +164,6 @@ friend class ItemLineEditDelegate;
     Q_INVOKABLE bool    isFractional();
 
   public slots:
-    void sHandleCompleter();
     void sInfo();
     void sCopy();
     void sList();
@@ -198,6 +197,10 @@ friend class ItemLineEditDelegate;
     itemSearch* searchFactory();
     void sUpdateMenu();
 
+  protected:
+    QString     completerQuery(const QString &prefix, QVariantMap &bindings);
+    QStringList completerColumns() const;
+
   private:
     void constructor();
 
@@ -13,8 +13,11 @@
 #include <QHBoxLayout>
 #include <QKeySequence>
 #include <QMessageBox>
+#include <QRegExp>
 #include <QSqlError>
 #include <QSqlRecord>
+#include <QStandardItemModel>
+#include <QTimer>
 #include <QVBoxLayout>
 
 #include "xlineedit.h"
@@ -22,11 +25,16 @@
 #include "xsqlquery.h"
 #include "xsqltablemodel.h"
 #include "shortcuts.h"
+#include "xsqlconnectionpool.h"
 
 #include "virtualCluster.h"
 
 #define DEBUG false
 
+// rows fetched per type-ahead lookup and ms of typing pause before one runs
+#define COMPLETERLIMIT 10
+#define COMPLETERDELAY 250
+
 void VirtualCluster::init()
 {
     _number = 0;
@@ -286,6 +294,10 @@ VirtualClusterLineEdit::VirtualClusterLineEdit(QWidget* pParent,
     _completer = 0;
     _showInactive = false;
     _completerId = 0;
+    _completerModel = 0;
+    _completerTimer = 0;
+    _completerSerial = 0;
+    _completerComplete = false;
 
     setTableAndColumnNames(pTabName, pIdColumn, pNumberColumn, pNameColumn, pDescripColumn, pActiveColumn);
 
@@ -303,8 +315,8 @@ VirtualClusterLineEdit::VirtualClusterLineEdit(QWidget* pParent,
     {
       if (!_x_metrics->boolean("DisableAutoComplete"))
       {
-        QSqlQueryModel* hints = new QSqlQueryModel(this);
-        _completer = new QCompleter(hints,this);
+        _completerModel = new QStandardItemModel(this);
+        _completer = new QCompleter(_completerModel, this);
         _completer->setWidget(this);
         QTreeView* view = new QTreeView(this);
         view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -317,6 +329,11 @@ VirtualClusterLineEdit::VirtualClusterLineEdit(QWidget* pParent,
         _completer->setModelSorting(QCompleter::CaseInsensitivelySortedModel);
         connect(this, SIGNAL(textEdited(QString)), this, SLOT(sHandleCompleter()));
         connect(_completer, SIGNAL(highlighted(QString)), this, SLOT(setText(QString)));
+
+        _completerTimer = new QTimer(this);
+        _completerTimer->setSingleShot(true);
+        _completerTimer->setInterval(COMPLETERDELAY);
+        connect(_completerTimer, SIGNAL(timeout()), this, SLOT(sCompleterLookup()));
         connect(_completer, SIGNAL(highlighted(const QModelIndex &)), this, SLOT(completerHighlighted(const QModelIndex &)));
       }
     }
@@ -500,59 +517,214 @@ void VirtualClusterLineEdit::setMenu(QMenu *menu)
   _menu = menu;
 }
 
+/* Type-ahead runs in stages so typing never waits on the database:
+   sHandleCompleter() restarts a short timer on every keystroke,
+   sCompleterLookup() sends the query to the XSqlConnectionPool when the
+   user pauses, and sCompleterFinished() shows the rows unless a
+   newer lookup has been sent since. If the last lookup returned every
+   match for a shorter prefix, the QCompleter narrows those rows itself
+   and no query is run at all.
+ */
 void VirtualClusterLineEdit::sHandleCompleter()
 {
-  if (!hasFocus())
+  if (!hasFocus() || !_completer)
     return;
 
   QString stripped = text().trimmed().toUpper();
   if (stripped.isEmpty())
+  {
+    _completerTimer->stop();
     return;
+  }
 
-  int width = 0;
-  QSqlQueryModel* model = static_cast<QSqlQueryModel *>(_completer->model());
-  QTreeView * view = static_cast<QTreeView *>(_completer->popup());
-  _parsed = true;
+  if (_completerComplete && ! _completerPrefix.isEmpty() &&
+      stripped.startsWith(_completerPrefix))
+  {
+    _completerTimer->stop();
+    if (_completerSerial)
+      XSqlConnectionPool::instance()->cancel(_completerSerial);
+    _completerSerial = 0;
+    showCompleter(stripped);
+    return;
+  }
+
+  _completerTimer->start();
+}
+
+void VirtualClusterLineEdit::sCompleterLookup()
+{
+  QString stripped = text().trimmed().toUpper();
+  if (!hasFocus() || !_completer || stripped.isEmpty())
+    return;
+
+  QVariantMap bindings;
+  QString sql = completerQuery(stripped, bindings) +
+                QString(" LIMIT %1;").arg(COMPLETERLIMIT);
+  _completerLookupPrefix = stripped;
+
+  if (XSqlConnectionPool::canRunThreaded())
+  {
+    XSqlConnectionPool *pool = XSqlConnectionPool::instance();
+    connect(pool, SIGNAL(queryFinished(qulonglong, QStringList, QVariantList, QString)),
+            this, SLOT(sCompleterFinished(qulonglong, QStringList, QVariantList, QString)),
+            Qt::UniqueConnection);
+    if (_completerSerial)
+      pool->cancel(_completerSerial);
+    _completerSerial = pool->exec(sql, bindings);
+    return;
+  }
+
+  // no second connection to use so look it up here
+  _completerSerial = 0;
   XSqlQuery numQ;
-  numQ.prepare(_query + _numClause +
-               (_extraClause.isEmpty() || !_strict ? "" : " AND " + _extraClause) +
-               ((_hasActive && ! _showInactive) ? _activeClause : "") +
-               QString(" ORDER BY %1 LIMIT 10;").arg(_numColName));
-  numQ.bindValue(":number", "^" + stripped);
+  numQ.prepare(sql);
+  QMapIterator<QString, QVariant> bind(bindings);
+  while (bind.hasNext())
+  {
+    bind.next();
+    numQ.bindValue(bind.key(), bind.value());
+  }
   numQ.exec();
-  if (numQ.first())
+
+  QStringList  columns;
+  QVariantList rows;
+  XSqlConnectionPool::read(numQ, columns, rows);
+  setCompleterRows(stripped, columns, rows);
+}
+
+void VirtualClusterLineEdit::sCompleterFinished(qulonglong serial,
+                                                const QStringList &columns,
+                                                const QVariantList &rows,
+                                                const QString &error)
+{
+  if (serial == 0 || serial != _completerSerial)
+    return;
+
+  _completerSerial = 0;
+  if (! error.isEmpty())
   {
-    int numberCol = numQ.record().indexOf("number");
-    int nameCol = numQ.record().indexOf("name");
-    int descripCol = numQ.record().indexOf("description");
-    model->setQuery(numQ);
-    _completer->setCompletionPrefix(stripped);
+    if (DEBUG)
+      qDebug("%s::sCompleterFinished() %s",
+             qPrintable(objectName()), qPrintable(error));
+    return;
+  }
 
-    for (int i = 0; i < model->columnCount(); i++)
-    {
-      if ( (i != numberCol) &&
-           (!_hasName || i != nameCol ) &&
-           (!_hasDescription || i != descripCol) )
-      {
-        view->hideColumn(i);
-      }
-    }
+  setCompleterRows(_completerLookupPrefix, columns, rows);
+}
+
+/* the SQL for the type-ahead rows starting with prefix, without LIMIT.
+   the match is built from _numClause so subclasses that change it are
+   honored. the usual case-insensitive regular expression on a column is
+   rewritten as a LIKE because that is cheaper to evaluate per row; an
+   index only helps if there is one on UPPER(column) built with
+   text_pattern_ops or the C collation. any other _numClause is used
+   as-is with :number anchored at the start, as it always was.
+ */
+QString VirtualClusterLineEdit::completerQuery(const QString &prefix, QVariantMap &bindings)
+{
+  QString numClause;
+  QRegExp regexClause("^\\s*AND\\s*\\((.+)\\s+~\\*\\s+:number\\)\\s*$");
+  if (regexClause.exactMatch(_numClause))
+  {
+    numClause = QString(" AND (UPPER(%1) LIKE :prefix) ").arg(regexClause.cap(1));
+    bindings.insert(":prefix", likePrefix(prefix));
+  }
+  else
+  {
+    numClause = _numClause;
+    bindings.insert(":number", "^" + prefix);
+  }
+
+  return _query + numClause +
+         (_extraClause.isEmpty() || !_strict ? "" : " AND " + _extraClause) +
+         ((_hasActive && ! _showInactive) ? _activeClause : "") +
+         QString(" ORDER BY %1").arg(_numColName);
+}
+
+/* the result columns shown in the type-ahead popup */
+QStringList VirtualClusterLineEdit::completerColumns() const
+{
+  QStringList columns("number");
+  if (_hasName)
+    columns << "name";
+  if (_hasDescription)
+    columns << "description";
+  return columns;
+}
+
+/* prefix escaped for use as the pattern of a LIKE 'prefix%' */
+QString VirtualClusterLineEdit::likePrefix(const QString &prefix)
+{
+  QString escaped = prefix;
+  escaped.replace("\\", "\\\\").replace("%", "\\%").replace("_", "\\_");
+  return escaped + "%";
+}
+
+void VirtualClusterLineEdit::clearCompleter()
+{
+  if (! _completer)
+    return;
 
-    view->resizeColumnToContents(numberCol);
-    width += view->columnWidth(numberCol);
-    if (_hasName)
+  _completerTimer->stop();
+  if (_completerSerial)
+    XSqlConnectionPool::instance()->cancel(_completerSerial);
+  _completerSerial = 0;
+  _completerPrefix.clear();
+  _completerComplete = false;
+  _completerModel->clear();
+}
+
+void VirtualClusterLineEdit::setCompleterRows(const QString &prefix,
+                                              const QStringList &columns,
+                                              const QVariantList &rows)
+{
+  _completerModel->clear();
+  _completerModel->setColumnCount(columns.size());
+  foreach (QVariant row, rows)
+  {
+    QList<QStandardItem*> items;
+    foreach (QVariant value, row.toList())
     {
-      view->resizeColumnToContents(nameCol);
-      width += view->columnWidth(nameCol);
+      QStandardItem *item = new QStandardItem;
+      item->setData(value, Qt::DisplayRole);
+      items.append(item);
     }
-    if (_hasDescription)
+    _completerModel->appendRow(items);
+  }
+
+  _completerColumns  = columns;
+  _completerPrefix   = prefix;
+  _completerComplete = rows.size() < COMPLETERLIMIT;
+
+  // the user may have typed past this lookup while it ran
+  QString stripped = text().trimmed().toUpper();
+  if (hasFocus() && stripped.startsWith(prefix))
+  {
+    if (stripped == prefix || _completerComplete)
+      showCompleter(stripped);
+    else
+      _completerTimer->start();
+  }
+}
+
+void VirtualClusterLineEdit::showCompleter(const QString &prefix)
+{
+  int width = 0;
+  QTreeView * view = static_cast<QTreeView *>(_completer->popup());
+  QStringList shown = completerColumns();
+
+  _completer->setCompletionPrefix(prefix);
+  for (int i = 0; i < _completerColumns.size(); i++)
+  {
+    if (shown.contains(_completerColumns.at(i)))
     {
-      view->resizeColumnToContents(descripCol);
-      width += view->columnWidth(descripCol);
+      view->showColumn(i);
+      view->resizeColumnToContents(i);
+      width += view->columnWidth(i);
     }
+    else
+      view->hideColumn(i);
   }
-  else
-    model->setQuery(QSqlQuery());
 
   if (width > 350)
     width = 350;
@@ -733,8 +905,7 @@ void VirtualClusterLineEdit::silentSetId(const int pId)
     idQ.exec();
     if (idQ.first())
     {
-      if (_completer)
-        static_cast<QSqlQueryModel* >(_completer->model())->setQuery(QSqlQuery());
+      clearCompleter();
 
       _id = pId;
       _valid = true;
@@ -35,6 +35,8 @@
 #include <QWidget>
 
 class QGridLayout;
+class QStandardItemModel;
+class QTimer;
 class VirtualClusterLineEdit;
 
 #define ID              1
@@ -212,6 +214,9 @@ class XTUPLEWIDGETS_EXPORT VirtualClusterLineEdit : public XLineEdit
 
         virtual void setStrikeOut(bool enable = false);
         virtual void sHandleCompleter();
+        virtual void sCompleterLookup();
+        virtual void sCompleterFinished(qulonglong serial, const QStringList &columns,
+                                        const QVariantList &rows, const QString &error);
         virtual void sHandleNullStr();
         virtual void sParse();
         virtual void sUpdateMenu();
@@ -275,8 +280,25 @@ class XTUPLEWIDGETS_EXPORT VirtualClusterLineEdit : public XLineEdit
 
         virtual void silentSetId(const int);
 
+        virtual QString     completerQuery(const QString &prefix, QVariantMap &bindings);
+        virtual QStringList completerColumns() const;
+        static  QString     likePrefix(const QString &prefix);
+        void clearCompleter();
+        void setCompleterRows(const QString &prefix, const QStringList &columns,
+                              const QVariantList &rows);
+        void showCompleter(const QString &prefix);
+
         QSqlQueryModel* _model;
 
+        // type-ahead state, see sHandleCompleter()
+        QStandardItemModel *_completerModel;
+        QTimer             *_completerTimer;
+        qulonglong          _completerSerial;
+        QString             _completerLookupPrefix; // prefix of the outstanding lookup
+        QString             _completerPrefix;       // prefix of the rows in _completerModel
+        QStringList         _completerColumns;
+        bool                _completerComplete;     // _completerModel holds every match
+
     private:
         void positionMenuLabel();
 
@@ -186,6 +186,7 @@ SOURCES += widgets.cpp \
     workcenterCluster.cpp \
     xcheckbox.cpp \
     xcombobox.cpp \
+    xcomboboxcache.cpp \
     xdatawidgetmapper.cpp \
     xdoccopysetter.cpp \
     xdoublevalidator.cpp \
@@ -199,6 +200,7 @@ SOURCES += widgets.cpp \
     xtextedit.cpp \
     xtreeview.cpp \
     xtreewidget.cpp \
+    xtreewidgetpopulator.cpp \
     xtreewidgetprogress.cpp \
     xurllabel.cpp \
 
@@ -279,6 +281,7 @@ HEADERS += widgets.h \
     workcentercluster.h \
     xcheckbox.h \
     xcombobox.h \
+    xcomboboxcache.h \
     xcomboboxprivate.h \
     xdatawidgetmapper.h \
     xdoccopysetter.h \
@@ -293,6 +296,7 @@ HEADERS += widgets.h \
     xtextedit.h \
     xtreeview.h \
     xtreewidget.h \
+    xtreewidgetpopulator.h \
     xtreewidgetprogress.h \
     xurllabel.h \
 
@@ -21,6 +21,7 @@
 class QLabel;
 class QMouseEvent;
 class QScriptEngine;
+class XComboBoxCacheEntry;
 class XComboBoxPrivate;
 class XDataWidgetMapper;
 
@@ -164,6 +165,7 @@ class XTUPLEWIDGETS_EXPORT XComboBox : public QComboBox
 
   protected:
     QString      currentDefault();
+    void         populate(const XComboBoxCacheEntry &, int = -1);
     void         mousePressEvent(QMouseEvent *);
 
     bool              _allowNull;
@@ -0,0 +1,97 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#include "xcomboboxcache.h"
+
+#include <QApplication>
+#include <QSqlError>
+#include <QSqlRecord>
+
+#include <xsqlquery.h>
+
+#define DEBUG false
+
+XComboBoxCache *XComboBoxCache::_instance = 0;
+
+XComboBoxCache *XComboBoxCache::instance()
+{
+  if (! _instance)
+    _instance = new XComboBoxCache(qApp);
+  return _instance;
+}
+
+XComboBoxCache::XComboBoxCache(QObject *parent)
+  : QObject(parent)
+{
+  setObjectName("XComboBoxCache");
+}
+
+XComboBoxCache::~XComboBoxCache()
+{
+  if (_instance == this)
+    _instance = 0;
+}
+
+/* return the cached rows for type, running sql only if the type has not
+   been loaded since the cache was last cleared. a failed query is
+   returned as-is but not cached so the next combobox tries again.
+ */
+XComboBoxCacheEntry XComboBoxCache::rows(int type, const QString &sql)
+{
+  QHash<int, XComboBoxCacheEntry>::const_iterator it = _entries.constFind(type);
+  if (it != _entries.constEnd())
+  {
+    if (DEBUG)
+      qDebug("XComboBoxCache::rows(%d) found %d cached rows",
+             type, it.value().ids.size());
+    return it.value();
+  }
+
+  XComboBoxCacheEntry entry;
+  XSqlQuery query(sql);
+  if (query.first())
+  {
+    bool hasCode = query.record().count() >= 3;
+    do
+    {
+      QString text = query.value(1).toString();
+      entry.ids.append(query.value(0).toInt());
+      entry.texts.append(text);
+      entry.codes.append(hasCode ? query.value(2).toString() : text);
+    } while (query.next());
+  }
+
+  if (query.lastError().type() != QSqlError::NoError)
+  {
+    if (DEBUG)
+      qDebug("XComboBoxCache::rows(%d) not caching after error %s",
+             type, qPrintable(query.lastError().text()));
+    return entry;
+  }
+
+  if (DEBUG)
+    qDebug("XComboBoxCache::rows(%d) cached %d rows", type, entry.ids.size());
+
+  _entries.insert(type, entry);
+  return entry;
+}
+
+void XComboBoxCache::clear()
+{
+  _entries.clear();
+}
+
+/* drop the cached rows for type. comboboxes already showing them are left
+   alone; the next one to ask for type reloads it.
+ */
+void XComboBoxCache::invalidate(int type)
+{
+  _entries.remove(type);
+}
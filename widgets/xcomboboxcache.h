@@ -0,0 +1,64 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#ifndef __XCOMBOBOXCACHE_H__
+#define __XCOMBOBOXCACHE_H__
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+#include "widgets.h"
+
+/* the rows one XComboBoxTypes lookup query returned. the lists are
+   implicitly shared, so every XComboBox filled from the same entry
+   shares one copy of the data.
+ */
+class XTUPLEWIDGETS_EXPORT XComboBoxCacheEntry
+{
+  public:
+    QList<int>  ids;
+    QStringList texts;
+    QStringList codes;
+};
+
+/* Process-wide cache of the XComboBox lookup lists, keyed by
+   XComboBoxTypes. XComboBox::setType() gets its rows from here so a
+   window with many comboboxes of the same type runs the query once.
+
+   The cache only lives as long as one window is being built: opening a
+   new window clears it, so every window starts with lists as fresh as
+   they were before the cache existed. XComboBox::populate() drops the
+   entry for its own type before reloading.
+ */
+class XTUPLEWIDGETS_EXPORT XComboBoxCache : public QObject
+{
+  Q_OBJECT
+
+  public:
+    static XComboBoxCache *instance();
+
+    XComboBoxCacheEntry rows(int type, const QString &sql);
+
+  public slots:
+    void clear();
+    void invalidate(int type);
+
+  private:
+    XComboBoxCache(QObject *parent = 0);
+    ~XComboBoxCache();
+
+    static XComboBoxCache *_instance;
+
+    QHash<int, XComboBoxCacheEntry> _entries;
+};
+
+#endif
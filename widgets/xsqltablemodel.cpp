@@ -9,10 +9,13 @@
  */
 
 #include <QDate>
+#include <QSet>
 #include <QSqlDriver>
+#include <QSqlError>
 #include <QSqlField>
 #include <QSqlIndex>
 #include <QSqlRelation>
+#include <QSqlResult>
 
 #include "format.h"
 #include "xsqlquery.h"
@@ -20,6 +23,45 @@
 
 #define DEBUG false
 
+/* serves rows XSqlTableNode::loadRows() already fetched to a model, so
+   the model can be filled without running its own select
+ */
+class XSqlTableCachedResult : public QSqlResult
+{
+  public:
+    XSqlTableCachedResult(const QSqlDriver *driver, const QSqlRecord &record,
+                          const QList<QVector<QVariant> > &rows)
+      : QSqlResult(driver),
+        _record(record),
+        _rows(rows)
+    {
+      setSelect(true);
+      setActive(true);
+      setAt(QSql::BeforeFirstRow);
+    }
+
+  protected:
+    QVariant   data(int i)        { return _rows.at(at()).value(i); }
+    bool       isNull(int i)      { return _rows.at(at()).value(i).isNull(); }
+    bool       reset(const QString &) { return false; }
+    bool       fetch(int i)
+    {
+      if (i < 0 || i >= _rows.count())
+        return false;
+      setAt(i);
+      return true;
+    }
+    bool       fetchFirst()       { return fetch(0); }
+    bool       fetchLast()        { return fetch(_rows.count() - 1); }
+    int        size()             { return _rows.count(); }
+    int        numRowsAffected()  { return 0; }
+    QSqlRecord record() const     { return _record; }
+
+  private:
+    QSqlRecord                _record;
+    QList<QVector<QVariant> > _rows;
+};
+
 XSqlTableNode::XSqlTableNode(const QString tableName, ParameterList relations, XSqlTableNode *parent)
     : QObject(parent)
 {
@@ -60,52 +102,135 @@ XSqlTableNode* XSqlTableNode::child(const QString &tableName)
   return 0;
 }
 
+/*! Returns the model holding the rows of this node that belong to \a row
+    of \a parent. Models are built on first use from the rows loadRows()
+    fetched, so untouched parents cost neither memory nor queries.
+ */
 XSqlTableModel* XSqlTableNode::model(XSqlTableModel* parent, int row)
 {
   QPair<XSqlTableModel*, int> key;
   key.first = parent;
   key.second = row;
-  return _modelMap.value(key);
+  if (_modelMap.contains(key) || !parent || _record.isEmpty())
+    return _modelMap.value(key);
+
+  ParameterList params = XSqlTableModel::buildParams(parent, row, _relations);
+  XSqlTableModel* cmodel = new XSqlTableModel(parent);
+  cmodel->setTable(_tableName);
+  cmodel->setFilter(XSqlTableModel::buildFilter(params));
+  cmodel->setCachedRows(_record, _rows.value(relationKey(params)));
+  _modelMap.insert(key, cmodel);
+  return cmodel;
 }
 
 /*! Clears the model map of the current node and recursively clears all child nodes */
 void XSqlTableNode::clear()
 {
   for (int n = 0; n < _children.count(); n++)
-  {
     _children.at(n)->clear();
-    _modelMap.clear();
-  }
+  _modelMap.clear();
+  _rows.clear();
+  _record.clear();
 }
 
+/*! Loads the child nodes for \a row of the model in \a key, which belongs to this node */
 void XSqlTableNode::load(QPair<XSqlTableModel*, int> key)
 {
-  XSqlTableModel* pmodel = key.first;
-  int row = key.second;
-
-  // Loop through each node and create a model parent model/row passed
   for (int n = 0; n < _children.count(); n++)
   {
     XSqlTableNode* node = _children.at(n);
+    node->loadRows(QList<ParameterList>()
+                   << XSqlTableModel::buildParams(key.first, key.second, node->relations()));
+    node->_modelMap.remove(key);
+  }
+}
+
+/*! Fetches the rows of this node for all of the \a parents with a single
+    query and groups them by parent. Then does the same for each child
+    node using the rows just fetched, so a tree costs one query per node
+    no matter how many rows it has.
+ */
+void XSqlTableNode::loadRows(const QList<ParameterList> &parents)
+{
+  if (parents.isEmpty())
+    return;
+
+  QStringList     clauses;
+  QSet<QString>   seen;
+  bool            everything = false;
+  for (int p = 0; p < parents.count(); p++)
+  {
+    ParameterList params = parents.at(p);
+    _rows.remove(relationKey(params)); // reloading replaces what was there
+    QString clause = XSqlTableModel::buildFilter(params);
+    if (clause.isEmpty())
+      everything = true;
+    else if (!seen.contains(clause))
+    {
+      seen.insert(clause);
+      clauses.append("(" + clause + ")");
+    }
+  }
+
+  XSqlTableModel all;
+  all.setTable(_tableName);
+  all.setFilter(everything ? QString() : clauses.join(" OR "));
 
-    XSqlTableModel* cmodel = new XSqlTableModel();
-    cmodel->setTable(_tableName);
-    ParameterList cparams = XSqlTableModel::buildParams(pmodel, row, _relations);
-    cmodel->setFilter(XSqlTableModel::buildFilter(cparams));
-    cmodel->select();
-    node->modelMap().insert(key, cmodel);
-
-    // Cascade recursively
-    QPair<XSqlTableModel*, int> ckey;
-    ckey.first = cmodel;
-    for (int r = 0; r < cmodel->rowCount(); r++)
+  QSqlQuery rowq(all.database());
+  rowq.setForwardOnly(true);
+  if (!rowq.exec(all.selectStatement()))
+  {
+    qWarning("XSqlTableNode::loadRows() could not load %s: %s",
+             qPrintable(_tableName), qPrintable(rowq.lastError().text()));
+    return;
+  }
+
+  _record = rowq.record();
+  QList<QVector<QVariant> > fetched;
+  while (rowq.next())
+  {
+    QVector<QVariant> row(_record.count());
+    for (int c = 0; c < _record.count(); c++)
+      row[c] = rowq.value(c);
+
+    ParameterList key;
+    for (int i = 0; i < _relations.count(); i++)
+      key.append(_relations.at(i).name(),
+                 row.value(_record.indexOf(_relations.at(i).name())));
+    _rows[relationKey(key)].append(row);
+    fetched.append(row);
+  }
+
+  if (DEBUG)
+    qDebug("XSqlTableNode::loadRows() %s: %d rows for %d parents",
+           qPrintable(_tableName), fetched.count(), parents.count());
+
+  // Cascade one level at a time
+  for (int n = 0; n < _children.count(); n++)
+  {
+    XSqlTableNode* node = _children.at(n);
+    QList<ParameterList> cparents;
+    for (int r = 0; r < fetched.count(); r++)
     {
-      key.second = r;
-      node->load(ckey);
+      ParameterList cparams;
+      for (int i = 0; i < node->relations().count(); i++)
+        cparams.append(node->relations().at(i).name(),
+                       fetched.at(r).value(_record.indexOf(node->relations().at(i).value().toString())));
+      cparents.append(cparams);
     }
+    node->loadRows(cparents);
   }
 }
 
+/* the grouping key for a parent row's relation values, in relation order */
+QString XSqlTableNode::relationKey(const ParameterList &params)
+{
+  QStringList values;
+  for (int i = 0; i < params.count(); i++)
+    values.append(params.at(i).value().toString());
+  return values.join(QChar(0x1f));
+}
+
 /* Saves the current model to the database*/
 bool XSqlTableNode::save()
 {
@@ -485,58 +610,46 @@ void XSqlTableModel::clearChildren()
 
 void XSqlTableModel::loadAll()
 {
-  qDebug("filter: %s", qPrintable(buildFilter(_params)));
+  if (DEBUG) qDebug("filter: %s", qPrintable(buildFilter(_params)));
   setFilter(buildFilter(_params));
   if (!query().isActive())
     select();
 
-  // Reset all nodes
+  // Reset all nodes and load each of them with one query for all rows
   for (int n = 0; n < _children.count(); n++)
   {
-    qDebug("clearing node %d", n);
     XSqlTableNode* node = _children.at(n);
-    QList<XSqlTableModel* > mlist;
     node->clear();
-  }
-  // Loop through and reload models for each row
-  for (int r = 0; r < rowCount(); r++)
-  {
-    qDebug("Loading row %d", r);
-    load(r);
+
+    QList<ParameterList> parents;
+    for (int r = 0; r < rowCount(); r++)
+      parents.append(buildParams(this, r, node->relations()));
+    node->loadRows(parents);
   }
 }
 
 void XSqlTableModel::load(int row)
 {
-  // Loop through each node to create models
+  QPair<XSqlTableModel*, int> key;
+  key.first = this;
+  key.second = row;
+
   for (int n = 0; n < _children.count(); n++)
   {
-    qDebug("loading child node %d", n);
+    if (DEBUG) qDebug("loading child node %d", n);
     XSqlTableNode* node = _children.at(n);
-    QPair<XSqlTableModel*, int> key;
-    key.first = this;
-    key.second = row;
-
-    // Generate child model for the row passed
-    XSqlTableModel* model = new XSqlTableModel(this);
-    qDebug("Setting table %s", qPrintable(node->tableName()));
-    model->setTable(node->tableName());
-    ParameterList params = buildParams(this, row, node->relations());
-    qDebug("Filter is %s", qPrintable(buildFilter(params)));
-    model->setFilter(buildFilter(params));
-    model->select();
-    node->modelMap().insert(key, model);
-
-    // Cascade recursively
-    key.first = model;
-    for (int r = 0; r < model->rowCount(); r++)
-    {
-      key.second = r;
-      node->load(key);
-    }
+    node->loadRows(QList<ParameterList>() << buildParams(this, row, node->relations()));
+    node->_modelMap.remove(key);
   }
 }
 
+/* fill the model with rows fetched elsewhere instead of selecting them */
+void XSqlTableModel::setCachedRows(const QSqlRecord &record, const QList<QVector<QVariant> > &rows)
+{
+  setQuery(QSqlQuery(new XSqlTableCachedResult(database().driver(), record, rows)));
+  applyColumnRoles();
+}
+
 /*!
     Saves the current model and all of it's child node models to the database where
     a\ transact wraps all submissions in a database transaction.
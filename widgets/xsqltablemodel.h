@@ -12,7 +12,9 @@
 #define XSQLTABLEMODEL_H
 
 #include <QSqlRelationalTableModel>
+#include <QSqlRecord>
 #include <QHash>
+#include <QVector>
 
 #include "widgets.h"
 
@@ -20,6 +22,8 @@ class XSqlTableModel;
 
 class XTUPLEWIDGETS_EXPORT XSqlTableNode : public QObject
 {
+  friend class XSqlTableModel;
+
 public:
   XSqlTableNode(const QString tableName, ParameterList relations, XSqlTableNode *parent = 0);
   ~XSqlTableNode();
@@ -41,21 +45,30 @@ public:
 
   void clear();
   void load(QPair<XSqlTableModel*, int> key);
+  void loadRows(const QList<ParameterList> &parents);
   bool save();
 
 private:
+  static QString relationKey(const ParameterList &params);
+
   ParameterList _relations;
   QMap<QPair<XSqlTableModel*, int>, XSqlTableModel* >_modelMap;
   QList<XSqlTableNode *> _children;
   QString _filter;
   QString _tableName;
   XSqlTableNode *_parent;
+
+  // rows fetched by loadRows(), grouped by the parent's relation values
+  QSqlRecord _record;
+  QHash<QString, QList<QVector<QVariant> > > _rows;
 };
 
 class XTUPLEWIDGETS_EXPORT XSqlTableModel : public QSqlRelationalTableModel
 {
     Q_OBJECT
 
+    friend class XSqlTableNode;
+
     public:
       XSqlTableModel(QObject *parent = 0);
       ~XSqlTableModel();
@@ -112,6 +125,8 @@ class XTUPLEWIDGETS_EXPORT XSqlTableModel : public QSqlRelationalTableModel
     bool save();
     
   private:
+    void setCachedRows(const QSqlRecord &record, const QList<QVector<QVariant> > &rows);
+
     QHash<QPair<QModelIndex, int>, QVariant> roles;
     QMultiHash<int, QPair<QVariant, int> > _columnRoles;
     QList<QString> _locales;
@@ -9,12 +9,15 @@
  */
 
 #include "xtextedit.h"
+#include <QTextBlock>
 #include <QTextCursor>
+#include <QTextDocument>
 #include <QContextMenuEvent>
 #include <QColor>
 
 GuiClientInterface* XTextEditHighlighter::_guiClientInterface = 0;
 GuiClientInterface* XTextEdit::_guiClientInterface = 0;
+QList<XTextEditHighlighter*> XTextEditHighlighter::_highlighters;
 
 XTextEdit::XTextEdit(QWidget *pParent) :
   QTextEdit(pParent)
@@ -102,8 +105,7 @@ void XTextEdit::sCorrectWord()
       QTextCursor cursor = cursorForPosition(_lastPos);
       cursor.select(QTextCursor::WordUnderCursor);
       cursor.deleteChar();
-      cursor.insertText(replacement);
-      _highlighter->rehighlight();
+      cursor.insertText(replacement); // rehighlights the edited block
    }
 }
 
@@ -116,7 +118,7 @@ void XTextEdit::sAddWord()
     int begin = textBlock.left(pos).lastIndexOf(QRegExp("\\W+"),pos);
     textBlock = textBlock.mid(begin+1,end-begin-1);
     _guiClientInterface->hunspell_add(textBlock);
-    _highlighter->rehighlight();
+    XTextEditHighlighter::rehighlightWord(textBlock);
 }
 
 
@@ -129,7 +131,7 @@ void XTextEdit::sIgnoreWord()
     int begin = textBlock.left(pos).lastIndexOf(QRegExp("\\W+"),pos);
     textBlock = textBlock.mid(begin+1,end-begin-1);
     _guiClientInterface->hunspell_ignore(textBlock);
-    _highlighter->rehighlight();
+    XTextEditHighlighter::rehighlightWord(textBlock);
 }
 
 
@@ -139,6 +141,7 @@ XTextEditHighlighter::XTextEditHighlighter(QObject *parent)
     HighlightingRule rule;
     _spellCheckFormat.setUnderlineColor(QColor(Qt::red));
     _spellCheckFormat.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+    _highlighters.append(this);
 }
 
 XTextEditHighlighter::XTextEditHighlighter(QTextDocument *document)
@@ -147,6 +150,7 @@ XTextEditHighlighter::XTextEditHighlighter(QTextDocument *document)
     HighlightingRule rule;
     _spellCheckFormat.setUnderlineColor(QColor(Qt::red));
     _spellCheckFormat.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+    _highlighters.append(this);
 }
 
 XTextEditHighlighter::XTextEditHighlighter(QTextEdit *editor)
@@ -155,10 +159,37 @@ XTextEditHighlighter::XTextEditHighlighter(QTextEdit *editor)
     HighlightingRule rule;
     _spellCheckFormat.setUnderlineColor(QColor(Qt::red));
     _spellCheckFormat.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+    _highlighters.append(this);
 }
 
 XTextEditHighlighter::~XTextEditHighlighter()
 {
+    _highlighters.removeAll(this);
+}
+
+// for when the dictionary becomes available
+void XTextEditHighlighter::rehighlightAll()
+{
+    foreach (XTextEditHighlighter *highlighter, _highlighters)
+      highlighter->rehighlight();
+}
+
+// for when a word is added to or ignored by the dictionary
+void XTextEditHighlighter::rehighlightWord(const QString &word)
+{
+    if (word.isEmpty())
+      return;
+
+    QRegExp wordExp("\\b" + QRegExp::escape(word) + "\\b");
+    foreach (XTextEditHighlighter *highlighter, _highlighters)
+    {
+      QTextDocument *doc = highlighter->document();
+      if (! doc)
+        continue;
+      for (QTextBlock block = doc->begin(); block.isValid(); block = block.next())
+        if (block.text().contains(wordExp))
+          highlighter->rehighlightBlock(block);
+    }
 }
 
 void XTextEditHighlighter::highlightBlock(const QString &text)
@@ -184,14 +215,13 @@ void XTextEditHighlighter::highlightBlock(const QString &text)
             {
                 if (_guiClientInterface->hunspell_check(word) < 1)
                 {
-                   int wordCount = text.count(QRegExp("\\b" + word + "\\b"));
-                   //loop through all repeated words in Line Edit
-                   int wordStartPos=-1;
-                   for (int repeatCount=0;repeatCount < wordCount; ++repeatCount)
+                   //mark all repeated words in Line Edit
+                   QRegExp wordExp("\\b" + word + "\\b");
+                   int wordStartPos = text.indexOf(wordExp);
+                   while (wordStartPos >= 0)
                    {
-                     wordStartPos = text.indexOf(QRegExp("\\b" + word + "\\b"),wordStartPos+1);
-                     if (wordStartPos>=0)
-                         setFormat(wordStartPos, word.length(), _spellCheckFormat);
+                     setFormat(wordStartPos, word.length(), _spellCheckFormat);
+                     wordStartPos = text.indexOf(wordExp, wordStartPos + 1);
                    }
                 }
              }
@@ -76,6 +76,9 @@ public:
     XTextEditHighlighter(QTextEdit *editor);
     ~XTextEditHighlighter();
 
+    static void rehighlightAll();
+    static void rehighlightWord(const QString &word);
+
 protected:
     virtual void highlightBlock(const QString &text);
 
@@ -98,6 +101,7 @@ private:
     QTextCharFormat _functionFormat;
     QTextCharFormat _spellCheckFormat;
 
+    static QList<XTextEditHighlighter*> _highlighters;
 }; // SPELLHIGHLIGHTER_H
 
 #endif
@@ -8,17 +8,20 @@
  * to be bound by its terms.
  */
 
+#include <algorithm>
 #include <limits>
 
 #include "xtreewidget.h"
 
 #include <QAction>
 #include <QApplication>
+#include <QBuffer>
 #include <QAbstractItemView>
 #include <QClipboard>
 #include <QDate>
 #include <QDateTime>
 #include <QDrag>
+#include <QFile>
 #include <QFileDialog>
 #include <QFont>
 #include <QHeaderView>
@@ -26,6 +29,7 @@
 #include <QMimeData>
 #include <QMouseEvent>
 #include <QProgressBar>
+#include <QProgressDialog>
 #include <QPushButton>
 #include <QSqlError>
 #include <QSqlRecord>
@@ -36,10 +40,14 @@
 #include <QTextEdit>
 #include <QTextTable>
 #include <QTextTableCell>
+#include <QTextStream>
 #include <QTextTableFormat>
+#include <QTreeWidgetItemIterator>
 #include <QtScript>
 #include <QMessageBox>
 
+#include "errorReporter.h"
+#include "xtreewidgetpopulator.h"
 #include "xtreewidgetprogress.h"
 #include "xtsettings.h"
 #include "xsqlquery.h"
@@ -49,28 +57,12 @@
 
 #define WORKERINTERVAL 0
 #define WORKERROWS     500
+// rows exported between progress signals
+#define EXPORTROWS     500
 
-/* make sure the colroles are kept in sync with
-   QStringList knownroles in populate() below,
-   both in count and order
-   */
-#define COLROLE_DISPLAY       0
-#define COLROLE_TEXTALIGNMENT 1
-#define COLROLE_BACKGROUND    2
-#define COLROLE_FOREGROUND    3
-#define COLROLE_TOOLTIP       4
-#define COLROLE_STATUSTIP     5
-#define COLROLE_FONT          6
-#define COLROLE_KEY           7
-#define COLROLE_RUNNING       8
-#define COLROLE_RUNNINGINIT   9
-#define COLROLE_GROUPRUNNING  10
-#define COLROLE_TOTAL         11
-#define COLROLE_NUMERIC       12
-#define COLROLE_NULL          13
-#define COLROLE_ID            14
-// make sure COLROLE_COUNT = last COLROLE + 1
-#define COLROLE_COUNT         15
+// the threaded populate hands rows to the GUI thread in bigger batches
+#define THREADEDINTERVAL 50
+#define THREADEDROWS     5000
 
 #define yesStr QObject::tr("Yes")
 #define noStr  QObject::tr("No")
@@ -79,26 +71,6 @@ GuiClientInterface *XTreeWidget::_guiClientInterface = 0;
 
 static QTreeWidgetItem *searchChildren(XTreeWidgetItem *item, int pId);
 
-// cint() and round() regarding Issue #8897
-#include <cmath>
-
-static double cint(double x)
-{
-  double intpart, fractpart;
-  fractpart = modf(x, &intpart);
-
-  if (fabs(fractpart) >= 0.5)
-    return x>=0 ? ceil(x) : floor(x);
-  else
-    return x<0 ? ceil(x) : floor(x);
-}
-
-static double round(double r, int places)
-{
-  double off=pow(10.0,places);
-  return cint(r*off)/off;
-}
-
 XTreeWidget::XTreeWidget(QWidget *pParent) :
   QTreeWidget(pParent)
 {
@@ -114,14 +86,19 @@ XTreeWidget::XTreeWidget(QWidget *pParent) :
   _linear  = false;
   _alwaysLinear = true;
 
-  _colIdx     = 0;  // querycol = _colIdx[xtreecol]
-  _colRole    = 0;  // querycol = _colRole[xtreecol][roleid]
+  _colMap     = 0;
   _fieldCount = 0;
   _last       = 0;
   for (int i = 0; i < ROWROLE_COUNT; i++)
     _rowRole[i] = 0;
   _progress = 0;
-  _subtotals = 0;
+  _calc      = 0;
+  _populator = 0;
+  _populatorIndex = -1;
+  _populatorCount = 0;
+  _threaded  = false;
+  _exportCancelled = false;
+  _exportDialog    = 0;
 
   setUniformRowHeights(true); //#13439 speed improvement if all rows are known to be the same height
   setContextMenuPolicy(Qt::CustomContextMenu);
@@ -146,6 +123,7 @@ XTreeWidget::XTreeWidget(QWidget *pParent) :
   connect(this,           SIGNAL(itemChanged(QTreeWidgetItem*, int)),                       SLOT(sItemChanged(QTreeWidgetItem*, int)));
   connect(this,           SIGNAL(itemClicked(QTreeWidgetItem*, int)),                       SLOT(sItemClicked(QTreeWidgetItem*, int)));
   connect(&_workingTimer, SIGNAL(timeout()), this, SLOT(populateWorker()));
+  connect(this, SIGNAL(exportProgress(int, int)), this, SLOT(sExportProgress(int, int)));
 
   emit valid(false);
   setColumnCount(0);
@@ -176,17 +154,13 @@ XTreeWidget::~XTreeWidget()
 {
   qApp->restoreOverrideCursor();
 
+  stopPopulator();
   cleanupAfterPopulate();
 
-  if (_subtotals)
+  if (_calc)
   {
-    for (int i = 0; i < _subtotals->size(); i++)
-    {
-      delete (*_subtotals)[i];
-      _subtotals->replace(i, 0);
-    }
-    delete _subtotals;
-    _subtotals = 0;
+    delete _calc;
+    _calc = 0;
   }
 
   if (_x_preferences)
@@ -252,6 +226,8 @@ void XTreeWidget::populate(XSqlQuery pQuery, int pIndex, bool pUseAltId, Populat
     clear();
     _workingParams.clear();
   }
+  else if (_calc)
+    _calc->stale = true;
   _workingParams.append(args);
 
   _linear = _alwaysLinear;
@@ -261,8 +237,100 @@ void XTreeWidget::populate(XSqlQuery pQuery, int pIndex, bool pUseAltId, Populat
     _workingTimer.start(WORKERINTERVAL);
 }
 
+/*!
+  Run \a pSql with the named \a pBindings and show the result.
+
+  If populateThreaded is set, the query runs and its rows are converted
+  on an XSqlConnectionPool connection and thread, so the GUI stays
+  responsive while large result sets load. Because that connection is a
+  separate session it cannot see uncommitted changes made on the main
+  connection, so only use this for read-only lists.
+  Otherwise this behaves like populate(XSqlQuery, int, bool, PopulateStyle).
+*/
+void XTreeWidget::populate(const QString &pSql, const QVariantMap &pBindings, int pIndex, bool pUseAltId, PopulateStyle popstyle)
+{
+  if (! _threaded || _roles.size() <= 0 ||
+      ! XTreeWidgetPopulator::canRunThreaded())
+  {
+    XSqlQuery query;
+    query.prepare(pSql);
+    QMapIterator<QString, QVariant> bind(pBindings);
+    while (bind.hasNext())
+    {
+      bind.next();
+      query.bindValue(bind.key(), bind.value());
+    }
+    query.exec();
+    // report errors here, as populateThreadedWorker() does
+    if (ErrorReporter::error(QtCriticalMsg, this, tr("Error Populating List"),
+                             query, __FILE__, __LINE__))
+    {
+      if (popstyle == Replace)
+        clear();
+      emit populated();
+      return;
+    }
+    populate(query, pIndex, pUseAltId, popstyle);
+    return;
+  }
+
+  int index = (pIndex < 0) ? id() : pIndex;
+
+  if (popstyle == Replace)
+  {
+    clear();
+    _workingParams.clear();
+  }
+  else if (_populator || _workingTimer.isActive())
+  {
+    // finish whatever is already loading so the rows stay in order
+    while (_populator || ! _workingParams.isEmpty())
+    {
+      if (_populator && ! _populator->isDone())
+        _populator->wait(THREADEDINTERVAL);
+      populateWorker();
+    }
+  }
+  if (popstyle == Append && _calc)
+    _calc->stale = true;
+
+  QStringList  colnames;
+  QVector<int> scales;
+  QVector<int> alignments;
+  columnDefinitions(colnames, scales, alignments);
+
+  cleanupAfterPopulate();
+  _populatorIndex = index;
+  _populatorCount = 0;
+  _populator = new XTreeWidgetPopulator(this);
+  _populator->setQuery(pSql, pBindings);
+  _populator->setColumns(colnames, scales, alignments, rootIsDecorated());
+  _populator->setUseAltId(pUseAltId);
+  // the worker must not load the locale itself
+  _populator->setFormats(XTreeWidgetFormats());
+  _populator->start();
+
+  if (! _progress)
+  {
+    _progress = new XTreeWidgetProgress(this);
+    connect(_progress, SIGNAL(cancel()), &_workingTimer, SLOT(stop()));
+    connect(_progress, SIGNAL(cancel()), this, SLOT(sPopulateCancelled()));
+  }
+  _progress->setValue(0);
+  _progress->setMaximum(0);
+  _progress->show();
+
+  _workingTimer.start(THREADEDINTERVAL);
+}
+
 void XTreeWidget::populateWorker()
 {
+  if (_populator)
+  {
+    populateThreadedWorker();
+    return;
+  }
+
   if (_workingParams.isEmpty())
   {
     if (DEBUG) qDebug("populateWorker called when no arguments were given.");
@@ -315,125 +383,26 @@ void XTreeWidget::populateWorker()
      taking into account that some places call xsqlquery::first() before
      xtreewidget::populate()
    */
-  if (pQuery.at() == QSql::BeforeFirstRow || (pQuery.at() == 0 && ! _colIdx))
+  if (pQuery.at() == QSql::BeforeFirstRow || (pQuery.at() == 0 && ! _colMap))
   {
     if (pQuery.first())
     {
       cleanupAfterPopulate(); // plug memory leaks if last populate() never finished
 
-      _fieldCount = pQuery.count();
-      // TODO: rewrite code to use a qmap or some other structure that
-      //       doesn't require initializing a Vector or new'd array values
-      _colIdx = new QVector<int>(_roles.size());
-
-      _colRole = new QVector<int *>(_roles.size(), 0);
-      for (int ref = 0; ref < _roles.size(); ++ref)
-        (*_colRole)[ref] = new int[COLROLE_COUNT];
-
-      if (! _subtotals)
-      {
-        _subtotals = new QList<QMap<int, double> *>();
-        for (int i = 0; i < _fieldCount; i++)
-          _subtotals->append(new QMap<int, double>());
-      }
-
-      QSqlRecord  currRecord = pQuery.record();
-
-      // apply indent, hidden and delete roles to col 0 if the caller requested them
-      // keep synchronized with #define ROWROLE_* above
-      if (rootIsDecorated())
-      {
-        _rowRole[ROWROLE_INDENT] = currRecord.indexOf("xtindentrole");
-        if (_rowRole[ROWROLE_INDENT] < 0)
-          _rowRole[ROWROLE_INDENT] = 0;
-      }
-      else
-        _rowRole[ROWROLE_INDENT] = 0;
-
-      _rowRole[ROWROLE_HIDDEN] = currRecord.indexOf("xthiddenrole");
-      if (_rowRole[ROWROLE_HIDDEN] < 0)
-        _rowRole[ROWROLE_HIDDEN] = 0;
-
-      _rowRole[ROWROLE_DELETED] = currRecord.indexOf("xtdeletedrole");
-      if (_rowRole[ROWROLE_DELETED] < 0)
-        _rowRole[ROWROLE_DELETED] = 0;
-
-      // keep synchronized with #define COLROLE_* above
-      // TODO: get rid of COLROLE_* above and replace this QStringList
-      // with a map or vector of known roles and their Qt:: role or Xt
-      // enum values
-      QStringList knownroles;
-      knownroles << "qtdisplayrole"      << "qttextalignmentrole"<<
-      "qtbackgroundrole"   << "qtforegroundrole"<<
-      "qttooltiprole"      << "qtstatustiprole"<<
-      "qtfontrole" << "xtkeyrole"<<
-      "xtrunningrole"      << "xtrunninginit"<<
-      "xtgrouprunningrole" << "xttotalrole"<<
-      "xtnumericrole" << "xtnullrole"<<
-      "xtidrole";
-      for (int wcol = 0; wcol < _roles.size(); wcol++)
-      {
-        QVariantMap *role = _roles.value(wcol);
-        if (!role)
-        {
-          qWarning("XTreeWidget::populate() there is no role for column %d", wcol);
-          continue;
-        }
-        QString colname = role->value("qteditrole").toString();
-        (*_colIdx)[wcol] = currRecord.indexOf(colname);
+      QStringList  colnames;
+      QVector<int> scales;
+      QVector<int> alignments;
+      columnDefinitions(colnames, scales, alignments);
 
-        for (int k = 0; k < knownroles.size(); k++)
-        {
-          // apply Qt roles to a whole row by applying to each column
-          (*_colRole)[wcol][k] = knownroles.at(k).startsWith("qt") ?
-                             currRecord.indexOf(knownroles.at(k)) :
-                             0;
-          if ((*_colRole)[wcol][k] > 0)
-          {
-            role->insert(knownroles.at(k),
-                          QString(knownroles.at(k)));
-          }
-          else
-            (*_colRole)[wcol][k] = 0;
-
-          // apply column-specific roles second to override entire row settings
-          if (currRecord.indexOf(colname + "_" + knownroles.at(k)) >=0)
-          {
-            (*_colRole)[wcol][k] = currRecord.indexOf(colname + "_" + knownroles.at(k));
-            role->insert(knownroles.at(k),
-                          QString(colname + "_" + knownroles.at(k)));
-            if (knownroles.at(k) == "xtrunningrole")
-              headerItem()->setData(wcol, Qt::UserRole, "xtrunningrole");
-            else if (knownroles.at(k) == "xttotalrole")
-                          headerItem()->setData(wcol, Qt::UserRole, "xttotalrole");
-          }
-        }
-
-        // Negative NUMERIC ROLE => default for column instead of column index
-        // see below
-        if (!(*_colRole)[wcol][COLROLE_NUMERIC] &&
-                          headerItem()->data(wcol, Xt::ScaleRole).isValid())
-        {
-          bool  ok;
-          int   tmpscale = headerItem()->data(wcol, Xt::ScaleRole).toInt(&ok);
-          if (ok)
-          {
-            if (DEBUG)
-              qDebug("setting _colRole[%d][COLROLE_NUMERIC]: %d", wcol, 0-tmpscale);
-            (*_colRole)[wcol][COLROLE_NUMERIC] = 0 - tmpscale;
-          }
-        }
-      }
-
-      if (_rowRole[ROWROLE_INDENT])
-        setIndentation( 10);
-      else
-        setIndentation( 0);
+      XTreeWidgetColumnMap map;
+      map.build(pQuery.record(), colnames, scales, alignments, rootIsDecorated());
+      setupColumnMap(map);
 
       if (! _linear && ! _progress)
       {
         _progress = new XTreeWidgetProgress(this);
         connect(_progress, SIGNAL(cancel()), &_workingTimer, SLOT(stop()));
+        connect(_progress, SIGNAL(cancel()), this, SLOT(sPopulateCancelled()));
       }
       if (_progress)
       {
@@ -444,7 +413,7 @@ void XTreeWidget::populateWorker()
     }
   }
 
-  int defaultScale = decimalPlaces("");
+  XTreeWidgetFormats formats;
   int cnt = 0;
 
   if (pQuery.at() >= 0) // if the query returned any rows at all
@@ -458,320 +427,304 @@ void XTreeWidget::populateWorker()
         return;
       }
 
-      int id         = pQuery.value(0).toInt();
-      int altId      = (pUseAltId) ? pQuery.value(1).toInt() : -1;
-      int indent     = 0;
-      int lastindent = 0;
-      if (_rowRole[ROWROLE_INDENT])
-      {
-        indent = pQuery.value(_rowRole[ROWROLE_INDENT]).toInt();
-        if (indent < 0)
-          indent = 0;
-        if (_last)
-        {
-          lastindent = _last->data(0, Xt::IndentRole).toInt();
-          if (DEBUG)
-                qDebug("getting Xt::IndentRole from %p of %d", _last, lastindent);
-        }
-      }
-      if (DEBUG)
-                qDebug("%s::populate() with id %d altId %d indent %d lastindent %d",
-                qPrintable(objectName()), id, altId, indent, lastindent);
-
-      QObject *parentItem = 0;
-      XTreeWidgetItem *previousItem = _last;
-      _last = new XTreeWidgetItem((XTreeWidgetItem*)0, id, altId);
-
-      if (indent == 0)
-        parentItem = this;
-      else if (lastindent < indent)
-        parentItem = previousItem;
-      else if (lastindent == indent)
-        parentItem = dynamic_cast<XTreeWidgetItem*>(previousItem->QTreeWidgetItem::parent());
-      else if (lastindent > indent)
-      {
-        XTreeWidgetItem *prev = (XTreeWidgetItem *)(previousItem->QTreeWidgetItem::parent());
-        while (prev &&
-               prev->data(0, Xt::IndentRole).toInt() >= indent)
-          prev = (XTreeWidgetItem *)(prev->QTreeWidgetItem::parent());
-        if (prev)
-          parentItem = prev;
-        else
-          parentItem = this;
-      }
-      else
-        parentItem = this;
+      XTreeWidgetRow row;
+      XTreeWidgetRow::decode(pQuery, pUseAltId, *_colMap, formats, row);
+      attachRow(row, topLevelItems);
+    } while (pQuery.next());
 
-      if (_rowRole[ROWROLE_INDENT])
-        _last->setData(0, Xt::IndentRole, indent);
+  this->addTopLevelItems(topLevelItems); //#13439
 
-      if (_rowRole[ROWROLE_HIDDEN])
-      {
-        if (DEBUG)
-          qDebug("%s::populate() found xthiddenrole, value = %s",
-                  qPrintable( objectName()),
-                  qPrintable( pQuery.value(_rowRole[ROWROLE_HIDDEN]).toString()));
-        _last->setHidden(pQuery.value(_rowRole[ROWROLE_HIDDEN]).toBool());
-      }
+  setId(pIndex);
+  emit valid(currentItem() != 0);
 
-      bool allNull = (indent > 0);
-      for (int col = 0; col < _roles.size(); col++)
-      {
-        QVariantMap *role = _roles.value(col);
-        if (!role)
-        {
-          qWarning("XTreeWidget::populate() there is no role for column %d", col);
-          continue;
-        }
+  // clean up. we won't reach here until the query is done, even if ! _linear
+  {
+    _workingTimer.stop();
 
-        QVariant rawValue;
-        if(_colIdx->at(col) >=0)  //#13439 optimization - only try to retrieve value if index is valid
-          rawValue = pQuery.value(_colIdx->at(col));
+    if (_workingParams.size())
+      _workingParams.takeFirst();
 
-        _last->setData(col, Xt::RawRole, rawValue);
+    cleanupAfterPopulate();
 
-        // TODO: this isn't necessary for all columns so do less often?
-        int     scale        = defaultScale;
-        QString numericrole  = "";
-        if ((*_colRole)[col][COLROLE_NUMERIC])
-        {
-          // Negative NUMERIC ROLE => default for column instead of column index
-          // see above
-          if ((*_colRole)[col][COLROLE_NUMERIC] < 0)
-            scale = 0 - (*_colRole)[col][COLROLE_NUMERIC];
-          else
-          {
-            numericrole  = pQuery.value((*_colRole)[col][COLROLE_NUMERIC]).toString();
-            scale        = decimalPlaces(numericrole);
-          }
-        }
+    updateCalculatedColumns(topLevelItemCount());
+    if (sortColumn() >= 0 && header()->isSortIndicatorShown())
+      sortItems(sortColumn(), header()->sortIndicatorOrder());
 
-        if ((*_colRole)[col][COLROLE_NUMERIC] ||
-            (*_colRole)[col][COLROLE_RUNNING] ||
-            (*_colRole)[col][COLROLE_TOTAL])
-          _last->setData(col, Xt::ScaleRole, scale);
-
-        /* if qtdisplayrole IS NULL then let the raw value shine through.
-           this allows UNIONS to do interesting things, like put dates and
-           text into the same visual column without SQL errors.
-        */
-        if ((*_colRole)[col][COLROLE_DISPLAY] &&
-            !pQuery.value((*_colRole)[col][COLROLE_DISPLAY]).isNull())
-        {
-          /* this might not handle PostgreSQL NUMERICs properly
-             but at least it will try to handle INTEGERs and DOUBLEs
-             and it will avoid formatting sales order numbers with decimal
-             and group separators
-          */
-          QVariant field = pQuery.value((*_colRole)[col][COLROLE_DISPLAY]);
-          if (field.type() == QVariant::Int)
-            _last->setData(col, Qt::DisplayRole,
-                          QLocale().toString(field.toInt()));
-          else if (field.type() == QVariant::Double)
-            _last->setData(col, Qt::DisplayRole,
-                          QLocale().toString(field.toDouble(),
-                                             'f', scale));
-          else
-            _last->setData(col, Qt::DisplayRole, field.toString());
-        }
-        else if (rawValue.isNull())
-        {
-          _last->setData(col, Qt::DisplayRole,
-                        (*_colRole)[col][COLROLE_NULL] ?
-                        pQuery.value((*_colRole)[col][COLROLE_NULL]).toString() :
-                        "");
-        }
-        else if ((*_colRole)[col][COLROLE_NUMERIC] &&
-                 ((numericrole == "percent") ||
-                  (numericrole == "scrap")))
-        {
-          _last->setData(col, Qt::DisplayRole,
-                          QLocale().toString(rawValue.toDouble() * 100.0,
-                                           'f', scale));
-        }
-        else if ((*_colRole)[col][COLROLE_NUMERIC] || rawValue.type() == QVariant::Double)
-        {
-          // Issue #8897
-          _last->setData(col, Qt::DisplayRole,
-                          QLocale().toString(round(rawValue.toDouble(), scale),
-                                           'f', scale));
-        }
-        else if (rawValue.type() == QVariant::Bool)
-        {
-          _last->setData(col, Qt::DisplayRole,
-                        rawValue.toBool() ? yesStr : noStr);
-        }
-        else
-        {
-          _last->setData(col, Qt::EditRole, rawValue);
-        }
+    if (DEBUG)
+      qDebug("%s::populateWorker() done", qPrintable(objectName()));
+    emit populated();
+  }
 
-        if (indent)
-        {
-          if (!(*_colRole)[col][COLROLE_DISPLAY] ||
-              ((*_colRole)[col][COLROLE_DISPLAY] &&
-               pQuery.value((*_colRole)[col][COLROLE_DISPLAY]).isNull()))
-            allNull &= (rawValue.isNull() || rawValue.toString().isEmpty());
-          else
-            allNull &= pQuery.value((*_colRole)[col][COLROLE_DISPLAY]).isNull() ||
-                       pQuery.value((*_colRole)[col][COLROLE_DISPLAY]).toString().isEmpty();
-
-          if (DEBUG)
-            qDebug("%s::populate() allNull = %d at %d for rawValue %s",
-                    qPrintable( objectName()), allNull, col,
-                    qPrintable( rawValue.toString()));
-        }
+  if (_linear)
+    qApp->restoreOverrideCursor();
+}
 
-        if ((*_colRole)[col][COLROLE_FOREGROUND])
-        {
-          QVariant fg = pQuery.value((*_colRole)[col][COLROLE_FOREGROUND]);
-          if (!fg.isNull())
-            _last->setData(col, Qt::ForegroundRole, namedColor(fg.toString()));
-        }
+/* collect what the XTreeWidgetColumnMap needs from the column
+   definitions so it can be built without touching the widget.
+ */
+void XTreeWidget::columnDefinitions(QStringList &colnames, QVector<int> &scales,
+                                    QVector<int> &alignments) const
+{
+  for (int col = 0; col < _roles.size(); col++)
+  {
+    QVariantMap *role = _roles.value(col);
+    colnames.append(role ? role->value("qteditrole").toString() : QString());
+    // a scale of 0 has the same effect as no scale at all
+    scales.append(headerItem()->data(col, Xt::ScaleRole).toInt());
+    alignments.append(headerItem()->textAlignment(col));
+  }
+}
 
-        if ((*_colRole)[col][COLROLE_BACKGROUND])
-        {
-          QVariant bg = pQuery.value((*_colRole)[col][COLROLE_BACKGROUND]);
-          if (!bg.isNull())
-            _last->setData(col, Qt::BackgroundRole, namedColor(bg.toString()));
-        }
+void XTreeWidget::setupColumnMap(const XTreeWidgetColumnMap &map)
+{
+  _colMap     = new XTreeWidgetColumnMap(map);
+  _fieldCount = map.fieldCount;
+  for (int i = 0; i < ROWROLE_COUNT; i++)
+    _rowRole[i] = map.rowRole[i];
 
-        if ((*_colRole)[col][COLROLE_TEXTALIGNMENT])
-        {
-          QVariant alignment = pQuery.value((*_colRole)[col][COLROLE_TEXTALIGNMENT]);
-          if (!alignment.isNull())
-            _last->setData(col, Qt::TextAlignmentRole, alignment);
-        }
-        else
-          _last->setData(col, Qt::TextAlignmentRole, headerItem()->textAlignment(col));
+  if (! _calc)
+    _calc = new XTreeWidgetCalculations(map.colIdx.size());
+  else if (_calc->running.size() < map.colIdx.size())
+    _calc->resize(map.colIdx.size());
 
-        if ((*_colRole)[col][COLROLE_TOOLTIP])
-        {
-          QVariant tooltip = pQuery.value((*_colRole)[col][COLROLE_TOOLTIP]);
-          if (!tooltip.isNull() )
-            _last->setData(col, Qt::ToolTipRole, tooltip);
-        }
+  for (int wcol = 0; wcol < map.roleNames.size() && wcol < _roles.size(); wcol++)
+  {
+    QVariantMap *role = _roles.value(wcol);
+    if (! role)
+      continue;
 
-        if ((*_colRole)[col][COLROLE_STATUSTIP])
-        {
-          QVariant statustip = pQuery.value((*_colRole)[col][COLROLE_STATUSTIP]);
-          if (!statustip.isNull())
-            _last->setData(col, Qt::StatusTipRole, statustip);
-        }
+    QMapIterator<QString, QVariant> it(map.roleNames.at(wcol));
+    while (it.hasNext())
+    {
+      it.next();
+      role->insert(it.key(), it.value());
+    }
 
-        if ((*_colRole)[col][COLROLE_FONT])
-        {
-          QVariant font = pQuery.value((*_colRole)[col][COLROLE_FONT]);
-          if (!font.isNull())
-            _last->setData(col, Qt::FontRole, font);
-        }
+    QString colname = role->value("qteditrole").toString();
+    if (map.roleNames.at(wcol).value("xttotalrole").toString() == colname + "_xttotalrole")
+      headerItem()->setData(wcol, Qt::UserRole, "xttotalrole");
+    else if (map.roleNames.at(wcol).value("xtrunningrole").toString() == colname + "_xtrunningrole")
+      headerItem()->setData(wcol, Qt::UserRole, "xtrunningrole");
+  }
 
-        if ((*_colRole)[col][COLROLE_RUNNINGINIT])
-        {
-          QVariant runninginit = pQuery.value((*_colRole)[col][COLROLE_RUNNINGINIT]);
-          if (!runninginit.isNull())
-            _last->setData(col, Xt::RunningInitRole, runninginit);
-        }
+  if (_rowRole[ROWROLE_INDENT])
+    setIndentation( 10);
+  else
+    setIndentation( 0);
+}
 
-        if ((*_colRole)[col][COLROLE_ID])
-        {
-          QVariant id = pQuery.value((*_colRole)[col][COLROLE_ID]);
-          if (!id.isNull())
-            _last->setData(col, Xt::IdRole, id);
-        }
+/* turn one decoded row into an XTreeWidgetItem and hang it in the tree.
+   top level items are collected in topLevelItems so the caller can add
+   them all at once.
+ */
+void XTreeWidget::attachRow(const XTreeWidgetRow &row, QList<XTreeWidgetItem*> &topLevelItems)
+{
+  int indent     = row.indent;
+  int lastindent = 0;
+  if (_rowRole[ROWROLE_INDENT] && _last)
+  {
+    lastindent = _last->data(0, Xt::IndentRole).toInt();
+    if (DEBUG)
+      qDebug("getting Xt::IndentRole from %p of %d", _last, lastindent);
+  }
+  if (DEBUG)
+    qDebug("%s::populate() with id %d altId %d indent %d lastindent %d",
+           qPrintable(objectName()), row.id, row.altId, indent, lastindent);
+
+  QObject *parentItem = 0;
+  XTreeWidgetItem *previousItem = _last;
+  _last = new XTreeWidgetItem((XTreeWidgetItem*)0, row.id, row.altId);
+
+  if (indent == 0)
+    parentItem = this;
+  else if (lastindent < indent)
+    parentItem = previousItem;
+  else if (lastindent == indent)
+    parentItem = dynamic_cast<XTreeWidgetItem*>(previousItem->QTreeWidgetItem::parent());
+  else if (lastindent > indent)
+  {
+    XTreeWidgetItem *prev = (XTreeWidgetItem *)(previousItem->QTreeWidgetItem::parent());
+    while (prev &&
+           prev->data(0, Xt::IndentRole).toInt() >= indent)
+      prev = (XTreeWidgetItem *)(prev->QTreeWidgetItem::parent());
+    if (prev)
+      parentItem = prev;
+    else
+      parentItem = this;
+  }
+  else
+    parentItem = this;
+
+  if (_rowRole[ROWROLE_INDENT])
+    _last->setData(0, Xt::IndentRole, indent);
+
+  if (_rowRole[ROWROLE_HIDDEN])
+    _last->setHidden(row.hidden);
+
+  _last->_keys.resize(row.cells.size());
+  for (int col = 0; col < row.cells.size(); col++)
+  {
+    if (! _colMap->valid.at(col))
+      continue;
+
+    const XTreeWidgetCell &cell = row.cells.at(col);
+
+    _last->setData(col, Xt::RawRole, cell.raw);
+    _last->_keys[col].rank    = cell.sortRank;
+    _last->_keys[col].number  = cell.sortNumber;
+    _last->_keys[col].numeric = cell.sortNumeric;
+    if (cell.scale >= 0)
+      _last->setData(col, Xt::ScaleRole, cell.scale);
+    _last->setData(col, Qt::DisplayRole, cell.display);
+
+    if (cell.foreground.isValid())
+      _last->setData(col, Qt::ForegroundRole, cell.foreground);
+    if (cell.background.isValid())
+      _last->setData(col, Qt::BackgroundRole, cell.background);
+    if (! cell.alignment.isNull())
+      _last->setData(col, Qt::TextAlignmentRole, cell.alignment);
+    if (! cell.toolTip.isNull())
+      _last->setData(col, Qt::ToolTipRole, cell.toolTip);
+    if (! cell.statusTip.isNull())
+      _last->setData(col, Qt::StatusTipRole, cell.statusTip);
+    if (! cell.font.isNull())
+      _last->setData(col, Qt::FontRole, cell.font);
+    if (! cell.runningInit.isNull())
+      _last->setData(col, Xt::RunningInitRole, cell.runningInit);
+    if (! cell.id.isNull())
+      _last->setData(col, Xt::IdRole, cell.id);
+
+    if (cell.hasRunningSet)
+    {
+      int set = cell.runningSet;
+      _last->setData(col, Xt::RunningSetRole, set);
+      /* rows arrive in display order so this is usually the final value.
+         updateCalculatedColumns() only redoes it after sorts or when
+         child rows were mixed in.
+       */
+      double &running = _calc->running[col].value(set, cell.runningInit.toDouble());
+      running += cell.raw.toDouble();
+      _last->setData(col, Qt::DisplayRole,
+                     QLocale().toString(running, 'f', cell.scale));
+    }
 
-        if ((*_colRole)[col][COLROLE_RUNNING])
-        {
-          int set = pQuery.value((*_colRole)[col][COLROLE_RUNNING]).toInt();
-          _last->setData(col, Xt::RunningSetRole, set);
-          /* performance hack - populateCalculatedColumns will repeat this
-             but only redraw if necessary. redraw is much slower than recalc. */
-          if (! _subtotals->at(col)->contains(set))
-          {
-            if ((*_colRole)[col][COLROLE_RUNNINGINIT])
-              (*_subtotals)[col]->insert(set, pQuery.value((*_colRole)[col][COLROLE_RUNNINGINIT]).toDouble());
-            else
-              (*_subtotals)[col]->insert(set, 0.0);
-          }
-          (*(*_subtotals)[col])[set] += rawValue.toDouble();
-          _last->setData(col, Qt::DisplayRole,
-                         QLocale().toString((*_subtotals)[col]->value(set), 'f', scale));
-        }
+    if (cell.hasTotalSet)
+    {
+      _last->setData(col, Xt::TotalSetRole, cell.totalSet);
+      // same seed as recalculateTotals(): the first top level row's init
+      double init = (parentItem == this) ?
+                    _last->data(col, Xt::TotalInitRole).toDouble() : 0.0;
+      _calc->totals[col].value(cell.totalSet, init) += cell.raw.toDouble();
+      if (cell.scale > _calc->totalScale.at(col))
+        _calc->totalScale[col] = cell.scale;
+    }
 
-        if ((*_colRole)[col][COLROLE_TOTAL])
-        {
-          _last->setData(col, Xt::TotalSetRole,
-                        pQuery.value((*_colRole)[col][COLROLE_TOTAL]).toInt());
-        }
+    if (row.deleted)
+    {
+      _last->setData(col,Xt::DeletedRole, QVariant(true));
+      QFont font = _last->font(col);
+      font.setStrikeOut(true);
+      _last->setFont(col, font);
+      _last->setTextColor(Qt::gray);
+    }
+  }
 
-        if (_rowRole[ROWROLE_DELETED])
-        {
-          if (DEBUG)
-            qDebug("%s::populate() found xtdeleterole, value = %s",
-                    qPrintable( objectName()),
-                    qPrintable( pQuery.value(_rowRole[ROWROLE_DELETED]).toString()));
-          if (pQuery.value(_rowRole[ROWROLE_DELETED]).toBool())
-          {
-            _last->setData(col,Xt::DeletedRole, QVariant(true));
-            QFont font = _last->font(col);
-            font.setStrikeOut(true);
-            _last->setFont(col, font);
-            _last->setTextColor(Qt::gray);
-          }
-        }
-        /*
-        if ((*_colRole)[col][COLROLE_KEY])
-          _last->setData(col, KeyRole, pQuery.value((*_colRole)[col][COLROLE_KEY]));
-        if ((*_colRole)[col][COLROLE_GROUPRUNNING])
-          _last->setData(col, GroupRunningRole, pQuery.value((*_colRole)[col][COLROLE_GROUPRUNNING]));
-        */
-      }
+  if (row.allNull && indent > 0)
+  {
+    qWarning("%s::populate() hiding indented row because it's empty",
+             qPrintable(objectName()));
+    _last->setHidden(true);
+  }
 
-      if (allNull && indent > 0)
-      {
-        qWarning("%s::populate() hiding indented row because it's empty",
-                 qPrintable(objectName()));
-        _last->setHidden(true);
-      }
+  if (qobject_cast<XTreeWidget*>(parentItem))
+  {
+    //#13439 optimization - do not add items to 'this' until the very end
+    if(parentItem == this)
+      topLevelItems.append(_last);
+    else
+      qobject_cast<XTreeWidget*>(parentItem)->addTopLevelItem(_last);
+  }
+  else if (qobject_cast<XTreeWidgetItem*>(parentItem))
+  {
+    qobject_cast<XTreeWidgetItem*>(parentItem)->addChild(_last);
+    // the running values above counted a child row
+    _calc->stale = true;
+  }
+}
 
-      if (qobject_cast<XTreeWidget*>(parentItem))
-      {
-        //#13439 optimization - do not add items to 'this' until the very end
-        if(parentItem == this)
-          topLevelItems.append(_last);
-        else
-          qobject_cast<XTreeWidget*>(parentItem)->addTopLevelItem(_last);
-      }
-      else if (qobject_cast<XTreeWidgetItem*>(parentItem))
-        qobject_cast<XTreeWidgetItem*>(parentItem)->addChild(_last);
+/* the GUI thread half of a threaded populate: pick up whatever rows the
+   XTreeWidgetPopulator has finished decoding and attach them in one go.
+ */
+void XTreeWidget::populateThreadedWorker()
+{
+  if (! _colMap && _populator->isMapped())
+  {
+    setupColumnMap(_populator->columnMap());
+    if (_progress)
+      _progress->setMaximum(_populator->size());
+  }
 
-    } while (pQuery.next());
+  bool done = _populator->isDone();
+  QList<XTreeWidgetRow> rows = _populator->takeRows(THREADEDROWS);
 
-  this->addTopLevelItems(topLevelItems); //#13439
+  if (_colMap && rows.size() > 0)
+  {
+    QList<XTreeWidgetItem*> topLevelItems;
+    for (int i = 0; i < rows.size(); i++)
+      attachRow(rows.at(i), topLevelItems);
+    addTopLevelItems(topLevelItems);
+    _populatorCount += rows.size();
+    if (_progress)
+      _progress->setValue(_populatorCount);
+  }
 
-  setId(pIndex);
+  if (! done || rows.size() >= THREADEDROWS)
+    return;
+
+  _workingTimer.stop();
+  QSqlError err = _populator->lastError();
+  stopPopulator();
+
+  if (err.type() != QSqlError::NoError)
+    ErrorReporter::error(QtCriticalMsg, this, tr("Error Populating List"),
+                         err, __FILE__, __LINE__);
+
+  setId(_populatorIndex);
   emit valid(currentItem() != 0);
 
-  // clean up. we won't reach here until the query is done, even if ! _linear
-  {
-    _workingTimer.stop();
+  cleanupAfterPopulate();
 
-    if (_workingParams.size())
-      _workingParams.takeFirst();
+  updateCalculatedColumns(topLevelItemCount());
+  if (sortColumn() >= 0 && header()->isSortIndicatorShown())
+    sortItems(sortColumn(), header()->sortIndicatorOrder());
 
-    cleanupAfterPopulate();
+  if (DEBUG)
+    qDebug("%s::populateThreadedWorker() done", qPrintable(objectName()));
+  emit populated();
+}
 
-    populateCalculatedColumns();
-    if (sortColumn() >= 0 && header()->isSortIndicatorShown())
-      sortItems(sortColumn(), header()->sortIndicatorOrder());
+/* let go of the XTreeWidgetPopulator without waiting for it.
+   it deletes itself once its thread finishes.
+ */
+void XTreeWidget::stopPopulator()
+{
+  if (! _populator)
+    return;
 
-    if (DEBUG)
-      qDebug("%s::populateWorker() done", qPrintable(objectName()));
-    emit populated();
-  }
+  _populator->cancel();
+  _populator->setParent(0);
+  _populator->deleteWhenFinished();
+  _populator = 0;
+}
 
-  if (_linear)
-    qApp->restoreOverrideCursor();
+void XTreeWidget::sPopulateCancelled()
+{
+  if (! _populator)
+    return;
+
+  stopPopulator();
+  cleanupAfterPopulate();
+  emit populated(); // whatever arrived before the cancel is the result
 }
 
 void XTreeWidget::cleanupAfterPopulate()
@@ -784,22 +737,9 @@ void XTreeWidget::cleanupAfterPopulate()
 
   _last = 0;
 
-  // TODO: get rid of this when the code is rewritten
-  //       as per above's todo about the QVector<int*>
-  if (_colRole)
-  {
-    for (int ref = 0; ref < _roles.size(); ++ref)
-    {
-      if ((*_colRole)[ref])
-        delete [] (*_colRole)[ref];
-    }
-    delete _colRole;
-    _colRole = 0;
-  }
-
-  if (_colIdx)
-    delete _colIdx;
-  _colIdx = 0;
+  if (_colMap)
+    delete _colMap;
+  _colMap = 0;
 
   _fieldCount = 0;
 }
@@ -976,8 +916,57 @@ QString XTreeWidgetItem::toString() const
   return QString(id());
 }
 
+void XTreeWidgetItem::setData(int colidx, int role, const QVariant &val)
+{
+  // the sort key was derived from the old raw value
+  if (role == Xt::RawRole && colidx >= 0 && colidx < _keys.size())
+    _keys[colidx].rank = XTreeWidgetItemKey::Unknown;
+
+  // populate() sets these before the item is in a tree and accounts for them
+  if (role == Xt::RawRole || role == Xt::TotalInitRole)
+  {
+    XTreeWidget *tree = qobject_cast<XTreeWidget *>(treeWidget());
+    if (tree && tree->_calc)
+    {
+      tree->_calc->stale       = true;
+      tree->_calc->totalsStale = true;
+    }
+  }
+  QTreeWidgetItem::setData(colidx, role, val);
+}
+
+/* fill key from the cache if populate() left one for this column,
+   otherwise derive it from Xt::RawRole. returns true if it was cached.
+ */
+bool XTreeWidgetItem::sortKey(int column, XTreeWidgetSortKey &key) const
+{
+  key.item = const_cast<XTreeWidgetItem *>(this);
+  if (column < 0 || column >= _keys.size() ||
+      _keys.at(column).rank == XTreeWidgetItemKey::Unknown)
+  {
+    XTreeWidgetSortKey derived(data(column, Xt::RawRole), key.item);
+    key = derived;
+    return false;
+  }
+
+  key.rank    = (XTreeWidgetSortKey::SortRank)_keys.at(column).rank;
+  key.number  = _keys.at(column).number;
+  key.numeric = _keys.at(column).numeric;
+  if (key.rank == XTreeWidgetSortKey::SortText)
+    key.text = data(column, Xt::RawRole).toString();
+  else
+    key.text.clear();
+  return true;
+}
+
 bool XTreeWidgetItem::operator<(const XTreeWidgetItem &other) const
 {
+  int col = treeWidget()->sortColumn();
+  XTreeWidgetSortKey k1;
+  XTreeWidgetSortKey k2;
+  if (sortKey(col, k1) && other.sortKey(other.treeWidget()->sortColumn(), k2))
+    return XTreeWidgetSortKey::lessThan(k1, k2);
+
   QVariant  v1         = data(treeWidget()->sortColumn(), Xt::RawRole);
   QVariant  v2         = other.data(other.treeWidget()->sortColumn(), Xt::RawRole);
 
@@ -1085,6 +1074,83 @@ bool XTreeWidgetItem::operator>(const XTreeWidgetItem &other) const
   return !(this < other || this == other);
 }
 */
+/* sortItems() compares these instead of calling XTreeWidgetItem::operator<
+   O(n log n) times. the ranking mirrors operator<: numbers sort before
+   strings that don't parse as non-zero numbers. like operator<, a typed
+   SQL null compares as its type's empty value, so a null number sorts
+   among the zeros, a null string with the empty strings, and a null date
+   before every real date. only values with no type at all sort last.
+ */
+XTreeWidgetSortKey::XTreeWidgetSortKey(const QVariant &value, XTreeWidgetItem *pItem)
+  : rank(SortNull), number(0.0), numeric(false), item(pItem)
+{
+  if (! value.isValid())
+    return;
+
+  rank = SortNumber;
+  switch (value.type())
+  {
+    case QVariant::Bool:
+      number = value.toBool() ? 1.0 : 0.0;
+      break;
+
+    case QVariant::Date:
+      number = value.isNull() ? -std::numeric_limits<double>::max()
+                              : value.toDate().toJulianDay();
+      break;
+
+    case QVariant::DateTime:
+      number = value.isNull() ? -std::numeric_limits<double>::max()
+                              : value.toDateTime().toMSecsSinceEpoch();
+      break;
+
+    case QVariant::Double:
+    case QVariant::Int:
+    case QVariant::LongLong:
+    case QVariant::UInt:
+    case QVariant::ULongLong:
+      number  = value.toDouble();
+      numeric = true;
+      break;
+
+    default:
+      text   = value.toString();
+      number = text.toDouble();
+      if (number == 0.0)
+        rank = SortText;
+  }
+}
+
+bool XTreeWidgetSortKey::lessThan(const XTreeWidgetSortKey &a, const XTreeWidgetSortKey &b)
+{
+  if (a.rank != b.rank)
+    return a.rank < b.rank;
+  if (a.rank == SortNumber)
+    return a.number < b.number;
+  return a.text < b.text;
+}
+
+static bool sortKeyAscending(const XTreeWidgetSortKey &a, const XTreeWidgetSortKey &b)
+{
+  return XTreeWidgetSortKey::lessThan(a, b);
+}
+
+static bool sortKeyDescending(const XTreeWidgetSortKey &a, const XTreeWidgetSortKey &b)
+{
+  return XTreeWidgetSortKey::lessThan(b, a);
+}
+
+static void saveItemState(QTreeWidgetItem *item, QList<QTreeWidgetItem *> &expanded,
+                          QList<QTreeWidgetItem *> &hidden)
+{
+  if (item->isExpanded())
+    expanded.append(item);
+  if (item->isHidden())
+    hidden.append(item);
+  for (int i = 0; i < item->childCount(); i++)
+    saveItemState(item->child(i), expanded, hidden);
+}
+
 void XTreeWidget::sortItems(int column, Qt::SortOrder order)
 {
   int previd = id();
@@ -1102,179 +1168,206 @@ void XTreeWidget::sortItems(int column, Qt::SortOrder order)
 
   header()->setSortIndicator(column, order);
 
-  // simple insertion sort using binary search to find the right insertion pt
+  /* extract a typed key from every top-level item once, sort the keys,
+     then put the items back in a single pass. children travel with their
+     parents but the view forgets expanded and hidden state on take.
+   */
+  removeTotalRows();
+
   QString totalrole("totalrole");
-  int     itemcount      = topLevelItemCount();
-  XTreeWidgetItem *prev  = dynamic_cast<XTreeWidgetItem *>(topLevelItem(0));
-  for (int i = 1; i < itemcount; i++)
+  QList<QTreeWidgetItem *> expanded;
+  QList<QTreeWidgetItem *> hidden;
+  for (int i = 0; i < topLevelItemCount(); i++)
+    saveItemState(topLevelItem(i), expanded, hidden);
+
+  QList<QTreeWidgetItem *> taken = invisibleRootItem()->takeChildren();
+  QVector<XTreeWidgetSortKey> keys;
+  keys.reserve(taken.size());
+  for (int i = 0; i < taken.size(); i++)
   {
-    XTreeWidgetItem *item = dynamic_cast<XTreeWidgetItem *>(topLevelItem(i));
+    XTreeWidgetItem *item = dynamic_cast<XTreeWidgetItem *>(taken.at(i));
     if (!item)
     {
       qWarning("removing a non-XTreWidgetItem from an XTreeWidget");
-      takeTopLevelItem(i);
-      itemcount--;
-      i--;
+      delete taken.at(i);
     }
     else if (item->data(0, Qt::UserRole).toString() == totalrole)
     {
       if (DEBUG)
         qDebug("sortItems() removing row %d because it's a totalrole", i);
-      takeTopLevelItem(i);
-      itemcount--;
-      i--;
-    }
-    else if (*item < *prev && order == Qt::AscendingOrder)
-    {
-      int left   = 0;
-      int right  = i;
-      int middle = 0;
-      XTreeWidgetItem *test = 0;
-      while (left <= right)
-      {
-        middle = (left + right) / 2;
-        test   = static_cast<XTreeWidgetItem *>(topLevelItem(middle));
-        if (*test == *item)
-          break;
-        else if (*test < *item)
-        {
-          if (*item < *(static_cast<XTreeWidgetItem *>(topLevelItem(middle + 1))))
-            break;
-          else
-            left = middle + 1;
-        }
-        else
-          right = middle - 1;
-      }
-      // can't call takeTopLevelItem() until after < and == are done
-      if (*item < *test || *item == *test)
-      {
-        if (DEBUG)
-          qDebug("<= so moving %d to %d", i, middle);
-        takeTopLevelItem(i);
-        insertTopLevelItem(middle, item);
-      }
-      else
-      {
-        if (DEBUG)
-          qDebug("> so moving %d to %d", i, middle + 1);
-        takeTopLevelItem(i);
-        insertTopLevelItem(middle + 1, item);
-      }
+      delete item;
     }
-    else if (*item == *prev)
+    else
     {
-      ; // nothing to do - make the > case easier to write
+      keys.append(XTreeWidgetSortKey());
+      item->sortKey(column, keys.last());
     }
-    else if (!(*item < *prev) && order == Qt::DescendingOrder)
-    {
-      int left   = 0;
-      int right  = i;
-      int middle = 0;
-      XTreeWidgetItem *test = 0;
-      while (left <= right)
-      {
-        middle = (left + right) / 2;
-        test   = static_cast<XTreeWidgetItem *>(topLevelItem(middle));
-        if (*test == *item)
-          break;
-        else if (!(*test < *item))
-        {
-          if (!(*item < *(static_cast<XTreeWidgetItem *>(topLevelItem(middle + 1)))))
-            break;
-          else
-            left = middle + 1;
-        }
-        else
-          right = middle - 1;
-      }
-      // can't call takeTopLevelItem() until after < and == are done
-      if (!(*item < *test) || *item == *test)
-      {
-        if (DEBUG)
-          qDebug(">= so moving %d to %d", i, middle);
-        takeTopLevelItem(i);
-        insertTopLevelItem(middle, item);
-      }
-      else
-      {
-        if (DEBUG)
-          qDebug("< so moving %d to %d", i, middle + 1);
-        takeTopLevelItem(i);
-        insertTopLevelItem(middle + 1, item);
-      }
-    }
-    // can't reuse item because the thing in position i may have changed
-    prev = static_cast<XTreeWidgetItem *>(topLevelItem(i));
   }
 
-  populateCalculatedColumns();
+  QVector<XTreeWidgetItem *> unsorted(keys.size());
+  for (int i = 0; i < keys.size(); i++)
+    unsorted[i] = keys.at(i).item;
+
+  if (order == Qt::AscendingOrder)
+    std::stable_sort(keys.begin(), keys.end(), sortKeyAscending);
+  else
+    std::stable_sort(keys.begin(), keys.end(), sortKeyDescending);
+
+  // running values above the first row that moved are still good
+  int firstMoved = keys.size();
+  QList<QTreeWidgetItem *> sorted;
+  sorted.reserve(keys.size());
+  for (int i = 0; i < keys.size(); i++)
+  {
+    sorted.append(keys.at(i).item);
+    if (firstMoved == keys.size() && keys.at(i).item != unsorted.at(i))
+      firstMoved = i;
+  }
+  QTreeWidget::addTopLevelItems(sorted);
+
+  for (int i = 0; i < expanded.size(); i++)
+    expanded.at(i)->setExpanded(true);
+  for (int i = 0; i < hidden.size(); i++)
+    hidden.at(i)->setHidden(true);
+
+  updateCalculatedColumns(firstMoved);
 
   setId(previd);
   emit resorted();
 }
 
+/* recalculate every xtrunningrole and xttotalrole column from scratch.
+   populate() and sortItems() keep these up to date on their own, so this
+   is only needed if items were added, removed or changed some other way.
+ */
 void XTreeWidget::populateCalculatedColumns()
 {
-  QMap<int, QMap<int, double> > totals; // <col <totalset, subtotal> >
-  QMap<int, int> scales;                // keep scale for the col, not col[totalset]
-  for (int col = 0; topLevelItem(0) &&
-       col < topLevelItem(0)->columnCount(); col++)
+  removeTotalRows();
+  if (! _calc)
+    _calc = new XTreeWidgetCalculations(columnCount());
+
+  recalculateTotals();
+  _calc->stale = true;
+  updateCalculatedColumns(0);
+}
+
+/* rebuild the xttotalrole accumulators by walking every item */
+void XTreeWidget::recalculateTotals()
+{
+  QList<int> totalcols;
+  for (int col = 0; col < _calc->totals.size() && col < columnCount(); col++)
   {
-    if (headerItem()->data(col, Qt::UserRole).toString() == "xtrunningrole")
+    if (headerItem()->data(col, Qt::UserRole).toString() == "xttotalrole")
     {
-      QMap<int, double> subtotals;
-      // assume that Xt::RunningSetRole exists if xtrunningrole exists
-      for (int row = 0; row < topLevelItemCount(); row++)
-      {
-        int set = topLevelItem(row)->data(col, Xt::RunningSetRole).toInt();
-        if (!subtotals.contains(set))
-          subtotals[set] = topLevelItem(row)->data(col, Xt::RunningInitRole).toDouble();
-        subtotals[set] += topLevelItem(row)->data(col, Xt::RawRole).toDouble();
-
-        // setData apparently knows if the value hasn't changed
-        topLevelItem(row)->setData(col, Qt::DisplayRole,
-                                   QLocale().toString(subtotals[set], 'f',
-                                                      topLevelItem(row)->data(col, Xt::ScaleRole).toInt()));
-      }
+      totalcols.append(col);
+      _calc->totals[col].clear();
+      _calc->totalScale[col] = 0;
     }
-    else if (headerItem()->data(col, Qt::UserRole).toString() == "xttotalrole")
+  }
+
+  // assume that Xt::TotalSetRole exists if xttotalrole exists
+  for (QTreeWidgetItemIterator it(this); *it && totalcols.size(); ++it)
+  {
+    QTreeWidgetItem *item = *it;
+    if (item->data(0, Qt::UserRole).toString() == "totalrole")
+      continue;
+    for (int i = 0; i < totalcols.size(); i++)
     {
-      QMap<int, double> totalset;
-      int colscale = -99999;
-      // assume that Xt::TotalSetRole exists if xttotalrole exists
-      for (int row = 0; row < topLevelItemCount(); row++)
-      {
-        int set = topLevelItem(row)->data(col, Xt::TotalSetRole).toInt();
-        if (!totalset.contains(set))
-          totalset[set] = topLevelItem(row)->data(col, Xt::TotalInitRole).toInt();
-        totalset[set] += topLevelItem(row)->totalForItem(col, set);
-        if (topLevelItem(row)->data(col, Xt::ScaleRole).toInt() > colscale)
-          colscale = topLevelItem(row)->data(col, Xt::ScaleRole).toInt();
-      }
-      totals.insert(col, totalset);
-      scales.insert(col, colscale);
+      int col = totalcols.at(i);
+      int set = item->data(col, Xt::TotalSetRole).toInt();
+      double init = item->parent() ? 0.0 : item->data(col, Xt::TotalInitRole).toDouble();
+      _calc->totals[col].value(set, init) += item->data(col, Xt::RawRole).toDouble();
+      int scale = item->data(col, Xt::ScaleRole).toInt();
+      if (scale > _calc->totalScale.at(col))
+        _calc->totalScale[col] = scale;
     }
   }
+  _calc->totalsStale = false;
+}
+
+/* redisplay running values from top level row first on, using the
+   accumulated totals, and append one total row per total set.
+ */
+void XTreeWidget::updateCalculatedColumns(int first)
+{
+  removeTotalRows();
+  if (! _calc)
+    return;
+
+  if (_calc->stale)
+  {
+    first = 0;
+    _calc->stale = false;
+  }
+  if (_calc->totalsStale)
+    recalculateTotals();
 
-  // punt: for now only report values of totalset[0] for each totaled col
-  // TODO: figure out how to handle multiple totalsets
-  if (totals.size() > 0)
+  int rows = topLevelItemCount();
+  for (int col = 0; first < rows && col < _calc->running.size(); col++)
   {
+    if (headerItem()->data(col, Qt::UserRole).toString() != "xtrunningrole")
+      continue;
+
+    // assume that Xt::RunningSetRole exists if xtrunningrole exists
+    XTreeWidgetAccumulator subtotals;
+    for (int row = 0; row < rows; row++)
+    {
+      XTreeWidgetItem *item = topLevelItem(row);
+      double &subtotal = subtotals.value(item->data(col, Xt::RunningSetRole).toInt(),
+                                         item->data(col, Xt::RunningInitRole).toDouble());
+      subtotal += item->data(col, Xt::RawRole).toDouble();
+      if (row >= first)
+        item->setData(col, Qt::DisplayRole,
+                      QLocale().toString(subtotal, 'f',
+                                         item->data(col, Xt::ScaleRole).toInt()));
+    }
+  }
+
+  QList<int> totalcols;
+  QList<int> sets;
+  for (int col = 0; col < _calc->totals.size() && col < columnCount(); col++)
+  {
+    if (headerItem()->data(col, Qt::UserRole).toString() != "xttotalrole")
+      continue;
+    totalcols.append(col);
+    const QVector<int> &colsets = _calc->totals.at(col).sets;
+    for (int i = 0; i < colsets.size(); i++)
+      if (! sets.contains(colsets.at(i)))
+        sets.append(colsets.at(i));
+  }
+  std::sort(sets.begin(), sets.end());
+
+  QString label = (totalcols.size() == 1) ? tr("Total") : tr("Totals");
+  for (int i = 0; i < sets.size(); i++)
+  {
+    int set = sets.at(i);
     XTreeWidgetItem *last = new XTreeWidgetItem(this, -1, -1,
-                                                (totals.size() == 1) ? tr("Total") : tr("Totals"));
+                                                (sets.size() == 1) ? label :
+                                                QString("%1 %2").arg(label).arg(set));
     last->setData(0, Qt::UserRole, "totalrole");
-    QMapIterator<int, QMap<int, double> > it(totals);
-    while (it.hasNext())
+    for (int j = 0; j < totalcols.size(); j++)
     {
-      it.next();
-      last->setData(it.key(), Qt::DisplayRole,
-                    QLocale().toString(it.value().value(0), 'f',
-                                       scales.value(it.key())));
+      int col = totalcols.at(j);
+      const XTreeWidgetAccumulator &total = _calc->totals.at(col);
+      int idx = total.indexOf(set);
+      last->setData(col, Qt::DisplayRole,
+                    QLocale().toString(idx >= 0 ? total.values.at(idx) : 0.0, 'f',
+                                       _calc->totalScale.at(col)));
     }
+    _calc->totalItems.append(last);
   }
 }
 
+void XTreeWidget::removeTotalRows()
+{
+  if (! _calc)
+    return;
+
+  for (int i = 0; i < _calc->totalItems.size(); i++)
+    delete _calc->totalItems.at(i).data(); // 0 if already deleted
+  _calc->totalItems.clear();
+}
+
 int XTreeWidget::id() const
 {
   QList<XTreeWidgetItem *> items = selectedItems();
@@ -1415,21 +1508,28 @@ void XTreeWidget::setPopulateLinear(bool alwaysLinear)
   _alwaysLinear = alwaysLinear;
 }
 
+bool XTreeWidget::populateThreaded() { return _threaded; }
+void XTreeWidget::setPopulateThreaded(bool threaded)
+{
+  _threaded = threaded;
+}
+
 void XTreeWidget::clear()
 {
   if (DEBUG)
     qDebug("%s::clear()", qPrintable(objectName()));
+  if (_populator)
+  {
+    _workingTimer.stop();
+    stopPopulator();
+    cleanupAfterPopulate();
+  }
   if (! _workingTimer.isActive())
     _workingParams.clear();
-  if (_subtotals)
+  if (_calc)
   {
-    for (int i = 0; i < _subtotals->size(); i++)
-    {
-      delete (*_subtotals)[i];
-      _subtotals->replace(i, 0);
-    }
-    delete _subtotals;
-    _subtotals = 0;
+    delete _calc;
+    _calc = 0;
   }
   emit valid(false);
   _savedId = false; // was -1;
@@ -1579,24 +1679,51 @@ void XTreeWidget::sExport()
 
   if (!fi.filePath().isEmpty())
   {
-    QTextDocument       *doc = new QTextDocument();
-    QTextDocumentWriter writer;
     if (fi.suffix().isEmpty())
       fi.setFile(fi.filePath() += defaultSuffix);
     xtsettingsSetValue(_settingsName + "/exportPath", fi.path());
-    writer.setFileName(fi.filePath());
 
-    if (fi.suffix() == "txt")
-    {
-      doc->setPlainText(toTxt());
-      writer.setFormat("plaintext");
-    }
-    else if (fi.suffix() == "csv")
+    // these stream straight to the file
+    if (fi.suffix() == "txt" || fi.suffix() == "csv" || fi.suffix() == "html")
     {
-      doc->setPlainText(toCsv());
-      writer.setFormat("plaintext");
+      QFile file(fi.filePath());
+      if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+      {
+        QMessageBox::critical(this, tr("Export Failed"),
+                              tr("Could not open %1 for writing:\n%2")
+                              .arg(fi.filePath(), file.errorString()));
+        return;
+      }
+
+      QProgressDialog progress(tr("Exporting..."), tr("Cancel"), 0, 0, this);
+      progress.setWindowModality(Qt::WindowModal);
+      connect(&progress, SIGNAL(canceled()), this, SLOT(cancelExport()));
+      _exportDialog = &progress;
+
+      ExportFormat format = ExportTxt;
+      if (fi.suffix() == "csv")
+        format = ExportCsv;
+      else if (fi.suffix() == "html")
+        format = ExportHtml;
+
+      bool ok = exportTo(&file, format);
+      _exportDialog = 0;
+      file.close();
+      if (! ok)
+      {
+        file.remove();
+        if (! _exportCancelled)
+          QMessageBox::critical(this, tr("Export Failed"),
+                                tr("Could not write %1").arg(fi.filePath()));
+      }
+      return;
     }
-    else if (fi.suffix() == "vcf")
+
+    QTextDocument       *doc = new QTextDocument();
+    QTextDocumentWriter writer;
+    writer.setFileName(fi.filePath());
+
+    if (fi.suffix() == "vcf")
     {
       doc->setPlainText(toVcf());
       writer.setFormat("plaintext");
@@ -1606,12 +1733,8 @@ void XTreeWidget::sExport()
       doc->setHtml(toHtml());
       writer.setFormat("odf");
     }
-    else if (fi.suffix() == "html")
-    {
-      doc->setHtml(toHtml());
-      writer.setFormat("HTML");
-    }
     writer.write(doc);
+    delete doc;
   }
 }
 
@@ -2271,20 +2394,42 @@ void XTreeWidget::sCopyVisibleToClipboard()
   QMimeData   *mime      = new QMimeData();
   QClipboard  *clipboard = QApplication::clipboard();
 
-  if (_x_preferences->boolean("CopyListsPlainText"))
-    mime->setText(toTxt());
+  QByteArray bytes;
+  QBuffer    buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+  bool plain = _x_preferences->boolean("CopyListsPlainText");
+  if (! exportTo(&buffer, plain ? ExportTxt : ExportHtml))
+  {
+    delete mime;
+    return;
+  }
+
+  if (plain)
+    mime->setText(QString::fromUtf8(bytes.constData(), bytes.size()));
   else
-    mime->setHtml(toHtml());
+    mime->setHtml(QString::fromUtf8(bytes.constData(), bytes.size()));
   clipboard->setMimeData(mime);
 }
 
 void XTreeWidget::sSearch(const QString &pTarget)
 {
   clearSelection();
+
+  /* a number matches regardless of how it's formatted for display.
+     text that only looks like a number, e.g. "007", must match as text.
+   */
+  XTreeWidgetSortKey target(pTarget);
+  XTreeWidgetSortKey key;
   int i;
   for (i = 0; i < topLevelItemCount(); i++)
   {
     // Currently this only looks at the first column
+    if (target.rank == XTreeWidgetSortKey::SortNumber)
+    {
+      topLevelItem(i)->sortKey(0, key);
+      if (key.numeric && key.number == target.number)
+        break;
+    }
     if (topLevelItem(i)->text(0).contains(pTarget, Qt::CaseInsensitive))
       break;
   }
@@ -2298,92 +2443,20 @@ void XTreeWidget::sSearch(const QString &pTarget)
 
 QString XTreeWidget::toTxt() const
 {
-  QString line;
-  QString opText;
-  int     counter;
-
-  QTreeWidgetItem *header = headerItem();
-  for (counter = 0; counter < header->columnCount(); counter++)
-  {
-    if (!QTreeWidget::isColumnHidden(counter))
-      line = line + header->text(counter).replace("\r\n"," ") + "\t";
-  }
-  opText = line + "\r\n";
-
-  XTreeWidgetItem *item = topLevelItem(0);
-  if (item)
-  {
-    QModelIndex idx = indexFromItem(item);
-    while (idx.isValid())
-    {
-      item = (XTreeWidgetItem *)itemFromIndex(idx);
-      if (item)
-      {
-        line = "";
-        for (counter = 0; counter < item->columnCount(); counter++)
-        {
-          if (!QTreeWidget::isColumnHidden(counter))
-            line = line + item->text(counter) + "\t";
-        }
-      }
-      opText = opText + line + "\r\n";
-      idx    = indexBelow(idx);
-    }
-  }
-  return opText;
+  QByteArray bytes;
+  QBuffer    buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+  writeExport(&buffer, ExportTxt, 0);
+  return QString::fromUtf8(bytes.constData(), bytes.size());
 }
 
 QString XTreeWidget::toCsv() const
 {
-  QString line;
-  QString opText;
-  int     counter;
-  int     colcount         = 0;
-
-  QTreeWidgetItem *header  = headerItem();
-  for (counter = 0; counter < header->columnCount(); counter++)
-  {
-    if (!QTreeWidget::isColumnHidden(counter))
-    {
-      if (colcount)
-        line = line + ",";
-      line = line + header->text(counter).replace("\"","\"\"").replace("\r\n"," ").replace("\n"," ");
-      colcount++;
-    }
-  }
-  opText = line + "\r\n";
-
-  XTreeWidgetItem *item = topLevelItem(0);
-  if (item)
-  {
-    QModelIndex idx = indexFromItem(item);
-    while (idx.isValid())
-    {
-      colcount = 0;
-      item     = (XTreeWidgetItem *)itemFromIndex(idx);
-      if (item)
-      {
-        line = "";
-        for (counter = 0; counter < item->columnCount(); counter++)
-        {
-          if (!QTreeWidget::isColumnHidden(counter))
-          {
-            if (colcount)
-              line = line + ",";
-            if (item->data(counter,Qt::DisplayRole).type() == QVariant::String)
-              line = line + "\"";
-            line = line + item->text(counter).replace("\"","\"\"");
-            if (item->data(counter,Qt::DisplayRole).type() == QVariant::String)
-              line = line + "\"";
-            colcount++;
-          }
-        }
-      }
-      opText = opText + line + "\r\n";
-      idx    = indexBelow(idx);
-    }
-  }
-  return opText;
+  QByteArray bytes;
+  QBuffer    buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+  writeExport(&buffer, ExportCsv, 0);
+  return QString::fromUtf8(bytes.constData(), bytes.size());
 }
 
 QString XTreeWidget::toVcf() const
@@ -2489,87 +2562,182 @@ QString XTreeWidget::toVcf() const
 
 QString XTreeWidget::toHtml() const
 {
-  QTextDocument     *doc     = new QTextDocument();
-  QTextCursor       *cursor  = new QTextCursor(doc);
-  QTextTableFormat  tableFormat;
-  QTextTableCell    cell;
-  QTextCharFormat   format;
-  QString font;
-  int     colcnt = 0;
-  int     rowcnt = 0;
+  QByteArray bytes;
+  QBuffer    buffer(&bytes);
+  buffer.open(QIODevice::WriteOnly);
+  writeExport(&buffer, ExportHtml, 0);
+  return QString::fromUtf8(bytes.constData(), bytes.size());
+}
 
-  tableFormat.setHeaderRowCount(1);
+/* write the visible columns of every row that indexBelow() reaches,
+   i.e. all top level rows and expanded children, to pDevice as it goes.
+   emits exportProgress() every so often and stops early if
+   cancelExport() gets called while the progress signal is handled.
+ */
+bool XTreeWidget::exportTo(QIODevice *pDevice, ExportFormat pFormat)
+{
+  _exportCancelled = false;
+  return writeExport(pDevice, pFormat, this);
+}
 
-  QTreeWidgetItem *header = headerItem();
-  for (int i = 0; i < header->columnCount(); i++)
-    if (!QTreeWidget::isColumnHidden(i))
-      colcnt++;
+void XTreeWidget::cancelExport()
+{
+  _exportCancelled = true;
+}
 
-  XTreeWidgetItem *item = topLevelItem(0);
-  if (item)
+void XTreeWidget::sExportProgress(int rows, int total)
+{
+  if (_exportDialog)
   {
-    QModelIndex idx = indexFromItem(item);
-    while (idx.isValid())
-    {
-      item = (XTreeWidgetItem *)itemFromIndex(idx);
-      if (item)
-        rowcnt++;
-      idx = indexBelow(idx);
-    }
+    _exportDialog->setMaximum(total);
+    _exportDialog->setValue(rows);   // processes events, so Cancel works
   }
+}
+
+static QString escapeHtml(const QString &text)
+{
+#if QT_VERSION >= 0x050000
+  return text.toHtmlEscaped();
+#else
+  return Qt::escape(text);
+#endif
+}
+
+static QString csvField(const QString &text)
+{
+  return QString(text).replace("\"", "\"\"");
+}
 
-  cursor->insertTable(rowcnt + 1, colcnt, tableFormat);
+/* pNotify is the widget to report progress to, or 0 when called from
+   one of the const to*() methods.
+ */
+bool XTreeWidget::writeExport(QIODevice *pDevice, ExportFormat pFormat, XTreeWidget *pNotify) const
+{
+  if (! pDevice || ! pDevice->isWritable())
+    return false;
 
+  QTextStream out(pDevice);
+  out.setCodec("UTF-8");
+
+  QList<int> cols;
+  QTreeWidgetItem *header = headerItem();
   for (int counter = 0; counter < header->columnCount(); counter++)
+    if (! QTreeWidget::isColumnHidden(counter))
+      cols.append(counter);
+
+  int total = 0;
+  if (pNotify)
+  {
+    for (QModelIndex idx = indexFromItem(QTreeWidget::topLevelItem(0));
+         idx.isValid(); idx = indexBelow(idx))
+      total++;
+    emit pNotify->exportProgress(0, total);
+  }
+
+  if (pFormat == ExportHtml)
+    out << "<html><head><meta http-equiv=\"Content-Type\" content=\"text/html; charset=utf-8\"/></head><body>\r\n"
+        << "<table border=\"1\" cellspacing=\"0\" cellpadding=\"2\">\r\n<tr>";
+  for (int i = 0; i < cols.size(); i++)
   {
-    if (!QTreeWidget::isColumnHidden(counter))
+    QString text = header->text(cols.at(i));
+    switch (pFormat)
     {
-      cell   = cursor->currentTable()->cellAt(cursor->position());
-      format = cell.format();
-      format.setBackground(Qt::lightGray);
-      cell.setFormat(format);
-      cursor->insertText(header->text(counter));
-      cursor->movePosition(QTextCursor::NextCell);
+      case ExportCsv:
+        if (i)
+          out << ",";
+        out << csvField(text).replace("\r\n", " ").replace("\n", " ");
+        break;
+      case ExportHtml:
+        out << "<th bgcolor=\"" << QColor(Qt::lightGray).name() << "\">"
+            << escapeHtml(text) << "</th>";
+        break;
+      default:
+        out << text.replace("\r\n", " ") << "\t";
     }
   }
+  out << (pFormat == ExportHtml ? "</tr>\r\n" : "\r\n");
 
-  item = topLevelItem(0);
-  if (item)
+  int rows = 0;
+  for (QModelIndex idx = indexFromItem(QTreeWidget::topLevelItem(0));
+       idx.isValid(); idx = indexBelow(idx))
   {
-    QModelIndex idx = indexFromItem(item);
-    while (idx.isValid())
+    QTreeWidgetItem *item = itemFromIndex(idx);
+    if (item)
     {
-      item = (XTreeWidgetItem *)itemFromIndex(idx);
-      if (item)
+      if (pFormat == ExportHtml)
+        out << "<tr>";
+      for (int i = 0; i < cols.size(); i++)
       {
-        for (int counter = 0; counter < item->columnCount(); counter++)
+        int col = cols.at(i);
+        if (col >= item->columnCount())
         {
-          if (!QTreeWidget::isColumnHidden(counter))
+          if (pFormat == ExportHtml)
+            out << "<td></td>";
+          else if (pFormat == ExportCsv && i)
+            out << ",";
+          else if (pFormat == ExportTxt)
+            out << "\t";
+          continue;
+        }
+
+        switch (pFormat)
+        {
+          case ExportCsv:
           {
-            cell   = cursor->currentTable()->cellAt(cursor->position());
-            format = cell.format();
-            if (item->data(counter, Qt::BackgroundRole).isValid())
-              format.setBackground(item->data(counter, Qt::BackgroundRole).value<QColor>());
-            if (item->data(counter, Qt::ForegroundRole).isValid())
-              format.setForeground(item->data(counter, Qt::ForegroundRole).value<QColor>());
-
-            if (item->data(counter,Qt::FontRole).isValid())
-            {
-              font = item->data(counter,Qt::FontRole).toString();
-              if (!font.isEmpty())
-                format.setFont(QFont(font));
-            }
-
-            cell.setFormat(format);
-            cursor->insertText(item->text(counter));
-            cursor->movePosition(QTextCursor::NextCell);
+            bool quote = (item->data(col, Qt::DisplayRole).type() == QVariant::String);
+            if (i)
+              out << ",";
+            if (quote)
+              out << "\"";
+            out << csvField(item->text(col));
+            if (quote)
+              out << "\"";
+            break;
           }
+
+          case ExportHtml:
+          {
+            QStringList style;
+            QVariant bg   = item->data(col, Qt::BackgroundRole);
+            QVariant fg   = item->data(col, Qt::ForegroundRole);
+            QVariant font = item->data(col, Qt::FontRole);
+            if (bg.isValid())
+              style << "background-color:" + bg.value<QColor>().name();
+            if (fg.isValid())
+              style << "color:" + fg.value<QColor>().name();
+            if (font.isValid() && ! font.toString().isEmpty())
+              style << "font-family:" + QFont(font.toString()).family();
+            out << "<td";
+            if (! style.isEmpty())
+              out << " style=\"" << escapeHtml(style.join(";")) << "\"";
+            out << ">" << escapeHtml(item->text(col)) << "</td>";
+            break;
+          }
+
+          default:
+            out << item->text(col) << "\t";
         }
       }
-      idx = indexBelow(idx);
+      if (pFormat == ExportHtml)
+        out << "</tr>";
+    }
+    out << "\r\n";
+
+    if (pNotify && ++rows % EXPORTROWS == 0)
+    {
+      emit pNotify->exportProgress(rows, total);
+      if (pNotify->_exportCancelled)
+        return false;
     }
   }
-  return doc->toHtml();
+
+  if (pFormat == ExportHtml)
+    out << "</table></body></html>\r\n";
+  out.flush();
+
+  if (pNotify)
+    emit pNotify->exportProgress(total, total);
+  return out.status() == QTextStream::Ok;
 }
 
 QList<XTreeWidgetItem *> XTreeWidget::selectedItems() const
@@ -2600,17 +2768,42 @@ XTreeWidgetItem *XTreeWidget::itemAbove(const XTreeWidgetItem *item) const
 
 QList<XTreeWidgetItem *> XTreeWidget::findItems(const QString &text, Qt::MatchFlags flags, int column, int role) const
 {
+  QList<XTreeWidgetItem *> xlist;
+
+  /* exact matches of a number against raw number values can use the
+     cached sort keys instead of converting every cell's QVariant. other
+     cells, including text that parses as a number, compare as QVariants
+     the way QAbstractItemModel::match() would.
+   */
+  XTreeWidgetSortKey target(text);
+  if (role == Xt::RawRole && target.rank == XTreeWidgetSortKey::SortNumber &&
+      (flags & 0x0F) == Qt::MatchExactly)
+  {
+    QVariant value(text);
+    XTreeWidgetSortKey key;
+    for (QTreeWidgetItemIterator it(const_cast<XTreeWidget *>(this)); *it; ++it)
+    {
+      XTreeWidgetItem *item = dynamic_cast<XTreeWidgetItem *>(*it);
+      if (! item || (! (flags & Qt::MatchRecursive) && item->QTreeWidgetItem::parent()))
+        continue;
+      item->sortKey(column, key);
+      if (key.numeric ? key.number == target.number
+                      : value == item->data(column, Xt::RawRole))
+        xlist.append(item);
+    }
+    return xlist;
+  }
+
   QModelIndexList indexes = model()->match(model()->index(0, column, QModelIndex()),
                                            role, text, -1, flags);
 
-  QList<XTreeWidgetItem *>  *xlist = new QList<XTreeWidgetItem *>();
   for (int i = 0; i < indexes.size(); ++i)
   {
     if (dynamic_cast<XTreeWidgetItem *>(itemFromIndex(indexes.at(i))))
-      xlist->append(dynamic_cast<XTreeWidgetItem *>(itemFromIndex(indexes.at(i))));
+      xlist.append(dynamic_cast<XTreeWidgetItem *>(itemFromIndex(indexes.at(i))));
   }
 
-  return *xlist;
+  return xlist;
 }
 
 void XTreeWidget::insertTopLevelItems(int index, const QList<XTreeWidgetItem *> &items)
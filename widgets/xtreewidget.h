@@ -54,7 +54,9 @@
 #include "xsqlquery.h"
 
 class QAction;
+class QIODevice;
 class QMenu;
+class QProgressDialog;
 class QScriptEngine;
 class XTreeWidget;
 class XTreeWidgetProgress;
@@ -62,6 +64,23 @@ class XTreeWidgetProgress;
 void  setupXTreeWidgetItem(QScriptEngine *engine);
 void  setupXTreeWidget(QScriptEngine *engine);
 
+class XTreeWidgetSortKey;
+
+/* how one cell's Xt::RawRole sorts, worked out once when the row is
+   populated so sorting and searching don't reparse it. rank matches
+   XTreeWidgetSortKey::SortRank, Unknown means not cached.
+ */
+class XTreeWidgetItemKey
+{
+  public:
+    enum { Unknown = -1 };
+    XTreeWidgetItemKey() : number(0.0), rank(Unknown), numeric(false) {}
+
+    double      number;
+    signed char rank;
+    bool        numeric;
+};
+
 class XTUPLEWIDGETS_EXPORT XTreeWidgetItem : public QObject, public QTreeWidgetItem
 {
   Q_OBJECT
@@ -130,11 +149,12 @@ class XTUPLEWIDGETS_EXPORT XTreeWidgetItem : public QObject, public QTreeWidgetI
     Q_INVOKABLE inline void             setAltId(int pId) { _altId = pId;  }
 
     Q_INVOKABLE inline QVariant         data(int colidx,    int role) const { return QTreeWidgetItem::data(colidx, role); }
-    Q_INVOKABLE inline void             setData(int colidx, int role, const QVariant &val) { QTreeWidgetItem::setData(colidx, role, val); }
+    Q_INVOKABLE virtual void            setData(int colidx, int role, const QVariant &val);
     Q_INVOKABLE virtual QVariant        rawValue(const QString colname);
     Q_INVOKABLE virtual int             id(const QString);
 
     virtual bool operator               <(const XTreeWidgetItem &other) const;
+    bool                                sortKey(int column, XTreeWidgetSortKey &key) const;
     virtual bool operator               ==(const XTreeWidgetItem &other) const;
 
     Q_INVOKABLE inline XTreeWidgetItem  *child(int idx) const
@@ -155,23 +175,33 @@ class XTUPLEWIDGETS_EXPORT XTreeWidgetItem : public QObject, public QTreeWidgetI
 
     int _id;
     int _altId;
+    QVector<XTreeWidgetItemKey> _keys;  // per column, filled by XTreeWidget::attachRow()
 };
 
 Q_DECLARE_METATYPE(XTreeWidgetItem *)
 // Q_DECLARE_METATYPE(XTreeWidgetItem)
 
+class XTreeWidgetCalculations;
+class XTreeWidgetColumnMap;
 class XTreeWidgetPopulateParams;
+class XTreeWidgetPopulator;
+class XTreeWidgetRow;
 
 class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
 {
   Q_OBJECT Q_PROPERTY(QString dragString READ dragString WRITE setDragString)
   Q_PROPERTY( QString altDragString READ altDragString WRITE setAltDragString)
   Q_PROPERTY( bool populateLinear READ populateLinear WRITE setPopulateLinear)
+  Q_PROPERTY( bool populateThreaded READ populateThreaded WRITE setPopulateThreaded)
 
   Q_ENUMS(PopulateStyle)
+  Q_ENUMS(ExportFormat)
+
+  friend class XTreeWidgetItem;
 
   public :
     enum PopulateStyle { Replace, Append };
+    enum ExportFormat  { ExportTxt, ExportCsv, ExportHtml };
     XTreeWidget(QWidget *);
     ~XTreeWidget();
 
@@ -179,6 +209,7 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     Q_INVOKABLE void  populate(XSqlQuery, int, bool = false, PopulateStyle = Replace);
     void    populate(const QString&, bool = false);
     void    populate(const QString&, int, bool = false);
+    Q_INVOKABLE void  populate(const QString&, const QVariantMap&, int = -1, bool = false, PopulateStyle = Replace);
 
     QString dragString() const;
     void    setDragString(QString);
@@ -186,6 +217,8 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     void    setAltDragString(QString);
     bool    populateLinear();
     void    setPopulateLinear(bool alwaysLinear = true);
+    bool    populateThreaded();
+    void    setPopulateThreaded(bool threaded = true);
 
     Q_INVOKABLE int   altId() const;
     Q_INVOKABLE int   id()    const;
@@ -208,6 +241,7 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     Q_INVOKABLE QString toCsv() const;
     Q_INVOKABLE QString toVcf() const;
     Q_INVOKABLE QString toHtml() const;
+    Q_INVOKABLE bool    exportTo(QIODevice *device, ExportFormat format);
 
     // just for scripting exposure:
     Q_INVOKABLE inline void addTopLevelItem(XTreeWidgetItem *item) {        QTreeWidget::addTopLevelItem(item); }
@@ -258,6 +292,7 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     void  showColumn(int colnum)  { QTreeWidget::showColumn(colnum); };
     void  showColumn(const QString&);
     void  sExport();
+    void  cancelExport();
     void  sCopyVisibleToClipboard();
     void  sCopyRowToClipboard();
     void  sCopyCellToClipboard();
@@ -282,6 +317,7 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     void  populateMenu(QMenu *, XTreeWidgetItem *, int);
     void  resorted();
     void  populated();
+    void  exportProgress(int rows, int total);
 
   protected slots:
     void  sHeaderClicked(int);
@@ -296,6 +332,7 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     void  sItemExpanded(QTreeWidgetItem *item);
     void  sItemPressed(QTreeWidgetItem *item, int column);
     void  populateWorker();
+    void  sPopulateCancelled();
 
   protected:
     QPoint        dragStartPosition;
@@ -329,14 +366,29 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     bool          _alwaysLinear;
     bool          _linear;
 
-    QVector<int>    *_colIdx;
-    QVector<int *>  *_colRole;
+    bool          _threaded;
+
+    XTreeWidgetColumnMap *_colMap;
     int              _fieldCount;
     XTreeWidgetItem *_last;
     int              _rowRole[ROWROLE_COUNT];
     void             cleanupAfterPopulate();
+    void             columnDefinitions(QStringList &, QVector<int> &, QVector<int> &) const;
+    void             setupColumnMap(const XTreeWidgetColumnMap &);
+    void             attachRow(const XTreeWidgetRow &, QList<XTreeWidgetItem*> &);
+    void             populateThreadedWorker();
+    void             updateCalculatedColumns(int first);
+    void             recalculateTotals();
+    void             removeTotalRows();
+    void             stopPopulator();
+    bool             writeExport(QIODevice *, ExportFormat, XTreeWidget *) const;
+    bool             _exportCancelled;
+    QProgressDialog *_exportDialog;
+    XTreeWidgetPopulator *_populator;
+    int              _populatorIndex;
+    int              _populatorCount;
     XTreeWidgetProgress *_progress;
-    QList<QMap<int, double> *> *_subtotals;
+    XTreeWidgetCalculations *_calc;
 
   private slots:
     void  sSelectionChanged();
@@ -352,6 +404,7 @@ class XTUPLEWIDGETS_EXPORT XTreeWidget : public QTreeWidget
     void  sToggleForgetfulness();
     void  sToggleForgetfulnessOrder();
     void  popupMenuActionTriggered(QAction *);
+    void  sExportProgress(int rows, int total);
 };
 
 class XTreeWidgetPopulateParams
@@ -0,0 +1,549 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#include "xtreewidgetpopulator.h"
+
+#include <QLocale>
+#include <QMutexLocker>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QStringList>
+
+#include <cmath>
+
+#include "format.h"
+
+#define DEBUG false
+
+// rows decoded between hand-offs to the GUI thread and cancel checks
+#define BATCHROWS 500
+
+// decoded rows waiting for the GUI thread before the worker pauses
+#define MAXBUFFERED (20 * BATCHROWS)
+
+#define yesStr QObject::tr("Yes")
+#define noStr  QObject::tr("No")
+
+// cint() and round() regarding Issue #8897
+static double cint(double x)
+{
+  double intpart, fractpart;
+  fractpart = modf(x, &intpart);
+
+  if (fabs(fractpart) >= 0.5)
+    return x>=0 ? ceil(x) : floor(x);
+  else
+    return x<0 ? ceil(x) : floor(x);
+}
+
+static double round(double r, int places)
+{
+  double off=pow(10.0,places);
+  return cint(r*off)/off;
+}
+
+double &XTreeWidgetAccumulator::value(int set, double init)
+{
+  int idx = sets.indexOf(set);
+  if (idx < 0)
+  {
+    idx = sets.size();
+    sets.append(set);
+    values.append(init);
+  }
+  return values[idx];
+}
+
+XTreeWidgetColumnMap::XTreeWidgetColumnMap()
+{
+  for (int i = 0; i < ROWROLE_COUNT; i++)
+    rowRole[i] = 0;
+  fieldCount = 0;
+}
+
+void XTreeWidgetColumnMap::build(const QSqlRecord &record,
+                                 const QStringList &colnames,
+                                 const QVector<int> &headerScales,
+                                 const QVector<int> &headerAlignments,
+                                 bool decorated)
+{
+  fieldCount = record.count();
+
+  // apply indent, hidden and delete roles to col 0 if the caller requested them
+  // keep synchronized with #define ROWROLE_* in xtreewidget.h
+  if (decorated)
+  {
+    rowRole[ROWROLE_INDENT] = record.indexOf("xtindentrole");
+    if (rowRole[ROWROLE_INDENT] < 0)
+      rowRole[ROWROLE_INDENT] = 0;
+  }
+  else
+    rowRole[ROWROLE_INDENT] = 0;
+
+  rowRole[ROWROLE_HIDDEN] = record.indexOf("xthiddenrole");
+  if (rowRole[ROWROLE_HIDDEN] < 0)
+    rowRole[ROWROLE_HIDDEN] = 0;
+
+  rowRole[ROWROLE_DELETED] = record.indexOf("xtdeletedrole");
+  if (rowRole[ROWROLE_DELETED] < 0)
+    rowRole[ROWROLE_DELETED] = 0;
+
+  // keep synchronized with #define COLROLE_* in xtreewidgetpopulator.h
+  QStringList knownroles;
+  knownroles << "qtdisplayrole"      << "qttextalignmentrole"<<
+  "qtbackgroundrole"   << "qtforegroundrole"<<
+  "qttooltiprole"      << "qtstatustiprole"<<
+  "qtfontrole" << "xtkeyrole"<<
+  "xtrunningrole"      << "xtrunninginit"<<
+  "xtgrouprunningrole" << "xttotalrole"<<
+  "xtnumericrole" << "xtnullrole"<<
+  "xtidrole";
+
+  int cols = colnames.size();
+  colIdx    = QVector<int>(cols, 0);
+  colRole   = QVector<QVector<int> >(cols, QVector<int>(COLROLE_COUNT, 0));
+  roleNames = QVector<QVariantMap>(cols);
+  valid     = QVector<bool>(cols, false);
+  alignment = headerAlignments;
+
+  for (int wcol = 0; wcol < cols; wcol++)
+  {
+    QString colname = colnames.at(wcol);
+    if (colname.isEmpty())
+    {
+      qWarning("XTreeWidget::populate() there is no role for column %d", wcol);
+      continue;
+    }
+    valid[wcol]  = true;
+    colIdx[wcol] = record.indexOf(colname);
+
+    QVector<int> &role = colRole[wcol];
+    for (int k = 0; k < knownroles.size(); k++)
+    {
+      // apply Qt roles to a whole row by applying to each column
+      role[k] = knownroles.at(k).startsWith("qt") ?
+                record.indexOf(knownroles.at(k)) : 0;
+      if (role[k] > 0)
+        roleNames[wcol].insert(knownroles.at(k), knownroles.at(k));
+      else
+        role[k] = 0;
+
+      // apply column-specific roles second to override entire row settings
+      int specific = record.indexOf(colname + "_" + knownroles.at(k));
+      if (specific >= 0)
+      {
+        role[k] = specific;
+        roleNames[wcol].insert(knownroles.at(k), colname + "_" + knownroles.at(k));
+      }
+    }
+
+    // Negative NUMERIC ROLE => default for column instead of column index
+    // see XTreeWidgetRow::decode()
+    if (! role[COLROLE_NUMERIC] && wcol < headerScales.size())
+    {
+      if (DEBUG)
+        qDebug("setting colRole[%d][COLROLE_NUMERIC]: %d",
+               wcol, 0 - headerScales.at(wcol));
+      role[COLROLE_NUMERIC] = 0 - headerScales.at(wcol);
+    }
+  }
+}
+
+XTreeWidgetFormats::XTreeWidgetFormats()
+{
+  defaultScale = decimalPlaces("");
+
+  QStringList scales;
+  scales << "qty"        << "curr"     << "percent"  << "cost"   << "qtyper"
+         << "salesprice" << "purchprice" << "uomratio" << "extprice" << "weight";
+  foreach (QString name, scales)
+    _scales.insert(name, decimalPlaces(name));
+
+  QStringList colors;
+  colors << "error" << "warning" << "emphasis" << "altemphasis"
+         << "expired" << "future";
+  foreach (QString name, colors)
+    _colors.insert(name, namedColor(name));
+}
+
+// same answers as decimalPlaces()
+int XTreeWidgetFormats::scale(const QString &name) const
+{
+  QHash<QString, int>::const_iterator it = _scales.constFind(name);
+  if (it != _scales.constEnd())
+    return it.value();
+  if (name.startsWith("curr"))
+    return _scales.value("curr");
+
+  bool ok = false;
+  int  result = name.toInt(&ok);
+  return ok ? result : defaultScale;
+}
+
+// same answers as namedColor()
+QColor XTreeWidgetFormats::color(const QString &name) const
+{
+  QHash<QString, QColor>::const_iterator it = _colors.constFind(name);
+  if (it != _colors.constEnd())
+    return it.value();
+
+  return QColor(name);
+}
+
+void XTreeWidgetRow::decode(const QSqlQuery &pQuery, bool pUseAltId,
+                            const XTreeWidgetColumnMap &map,
+                            const XTreeWidgetFormats &formats,
+                            XTreeWidgetRow &row)
+{
+  row.id    = pQuery.value(0).toInt();
+  row.altId = (pUseAltId) ? pQuery.value(1).toInt() : -1;
+
+  if (map.rowRole[ROWROLE_INDENT])
+  {
+    row.indent = pQuery.value(map.rowRole[ROWROLE_INDENT]).toInt();
+    if (row.indent < 0)
+      row.indent = 0;
+  }
+
+  if (map.rowRole[ROWROLE_HIDDEN])
+    row.hidden = pQuery.value(map.rowRole[ROWROLE_HIDDEN]).toBool();
+
+  if (map.rowRole[ROWROLE_DELETED])
+    row.deleted = pQuery.value(map.rowRole[ROWROLE_DELETED]).toBool();
+
+  row.allNull = (row.indent > 0);
+  row.cells.resize(map.colIdx.size());
+  for (int col = 0; col < map.colIdx.size(); col++)
+  {
+    if (! map.valid.at(col))
+      continue;
+
+    const QVector<int> &role = map.colRole.at(col);
+    XTreeWidgetCell    &cell = row.cells[col];
+
+    if (map.colIdx.at(col) >= 0)  //#13439 optimization - only try to retrieve value if index is valid
+      cell.raw = pQuery.value(map.colIdx.at(col));
+
+    // classify once here, maybe on the worker thread, instead of per compare
+    XTreeWidgetSortKey key(cell.raw);
+    cell.sortRank    = key.rank;
+    cell.sortNumber  = key.number;
+    cell.sortNumeric = key.numeric;
+
+    int     scale        = formats.defaultScale;
+    QString numericrole  = "";
+    if (role[COLROLE_NUMERIC])
+    {
+      // Negative NUMERIC ROLE => default for column instead of column index
+      if (role[COLROLE_NUMERIC] < 0)
+        scale = 0 - role[COLROLE_NUMERIC];
+      else
+      {
+        numericrole  = pQuery.value(role[COLROLE_NUMERIC]).toString();
+        scale        = formats.scale(numericrole);
+      }
+    }
+
+    if (role[COLROLE_NUMERIC] || role[COLROLE_RUNNING] || role[COLROLE_TOTAL])
+      cell.scale = scale;
+
+    /* if qtdisplayrole IS NULL then let the raw value shine through.
+       this allows UNIONS to do interesting things, like put dates and
+       text into the same visual column without SQL errors.
+    */
+    QVariant field;
+    if (role[COLROLE_DISPLAY])
+      field = pQuery.value(role[COLROLE_DISPLAY]);
+
+    if (role[COLROLE_DISPLAY] && ! field.isNull())
+    {
+      /* this might not handle PostgreSQL NUMERICs properly
+         but at least it will try to handle INTEGERs and DOUBLEs
+         and it will avoid formatting sales order numbers with decimal
+         and group separators
+      */
+      if (field.type() == QVariant::Int)
+        cell.display = QLocale().toString(field.toInt());
+      else if (field.type() == QVariant::Double)
+        cell.display = QLocale().toString(field.toDouble(), 'f', scale);
+      else
+        cell.display = field.toString();
+    }
+    else if (cell.raw.isNull())
+      cell.display = role[COLROLE_NULL] ?
+                     pQuery.value(role[COLROLE_NULL]).toString() : QString("");
+    else if (role[COLROLE_NUMERIC] &&
+             ((numericrole == "percent") || (numericrole == "scrap")))
+      cell.display = QLocale().toString(cell.raw.toDouble() * 100.0, 'f', scale);
+    else if (role[COLROLE_NUMERIC] || cell.raw.type() == QVariant::Double)
+      cell.display = formatNumber(cell.raw.toDouble(), scale);
+    else if (cell.raw.type() == QVariant::Bool)
+      cell.display = cell.raw.toBool() ? yesStr : noStr;
+    else
+      cell.display = cell.raw;
+
+    if (row.indent)
+    {
+      if (! role[COLROLE_DISPLAY] || field.isNull())
+        row.allNull &= (cell.raw.isNull() || cell.raw.toString().isEmpty());
+      else
+        row.allNull &= field.toString().isEmpty();
+    }
+
+    if (role[COLROLE_FOREGROUND])
+    {
+      QVariant fg = pQuery.value(role[COLROLE_FOREGROUND]);
+      if (! fg.isNull())
+        cell.foreground = formats.color(fg.toString());
+    }
+
+    if (role[COLROLE_BACKGROUND])
+    {
+      QVariant bg = pQuery.value(role[COLROLE_BACKGROUND]);
+      if (! bg.isNull())
+        cell.background = formats.color(bg.toString());
+    }
+
+    if (role[COLROLE_TEXTALIGNMENT])
+    {
+      QVariant alignment = pQuery.value(role[COLROLE_TEXTALIGNMENT]);
+      if (! alignment.isNull())
+        cell.alignment = alignment;
+    }
+    else if (col < map.alignment.size())
+      cell.alignment = map.alignment.at(col);
+
+    if (role[COLROLE_TOOLTIP])
+      cell.toolTip = pQuery.value(role[COLROLE_TOOLTIP]);
+
+    if (role[COLROLE_STATUSTIP])
+      cell.statusTip = pQuery.value(role[COLROLE_STATUSTIP]);
+
+    if (role[COLROLE_FONT])
+      cell.font = pQuery.value(role[COLROLE_FONT]);
+
+    if (role[COLROLE_RUNNINGINIT])
+      cell.runningInit = pQuery.value(role[COLROLE_RUNNINGINIT]);
+
+    if (role[COLROLE_ID])
+      cell.id = pQuery.value(role[COLROLE_ID]);
+
+    if (role[COLROLE_RUNNING])
+    {
+      cell.hasRunningSet = true;
+      cell.runningSet    = pQuery.value(role[COLROLE_RUNNING]).toInt();
+    }
+
+    if (role[COLROLE_TOTAL])
+    {
+      cell.hasTotalSet = true;
+      cell.totalSet    = pQuery.value(role[COLROLE_TOTAL]).toInt();
+    }
+  }
+}
+
+// Issue #8897
+QString XTreeWidgetRow::formatNumber(double value, int scale)
+{
+  return QLocale().toString(round(value, scale), 'f', scale);
+}
+
+XTreeWidgetPopulator::XTreeWidgetPopulator(QObject *parent)
+  : XSqlPoolTask(parent),
+    _decorated(false),
+    _useAltId(false),
+    _cancelled(false),
+    _done(false),
+    _mapped(false),
+    _size(-1),
+    _decoded(0)
+{
+}
+
+XTreeWidgetPopulator::~XTreeWidgetPopulator()
+{
+  if (DEBUG)
+    qDebug("XTreeWidgetPopulator::~XTreeWidgetPopulator() decoded %d rows",
+           _decoded);
+}
+
+bool XTreeWidgetPopulator::canRunThreaded()
+{
+  return XSqlConnectionPool::canRunThreaded();
+}
+
+void XTreeWidgetPopulator::setQuery(const QString &sql, const QVariantMap &bindings)
+{
+  _sql      = sql;
+  _bindings = bindings;
+}
+
+void XTreeWidgetPopulator::setColumns(const QStringList &colnames,
+                                      const QVector<int> &headerScales,
+                                      const QVector<int> &headerAlignments,
+                                      bool decorated)
+{
+  _colnames         = colnames;
+  _headerScales     = headerScales;
+  _headerAlignments = headerAlignments;
+  _decorated        = decorated;
+}
+
+void XTreeWidgetPopulator::setUseAltId(bool useAltId)
+{
+  _useAltId = useAltId;
+}
+
+// call on the GUI thread, before start()
+void XTreeWidgetPopulator::setFormats(const XTreeWidgetFormats &formats)
+{
+  _formats = formats;
+}
+
+void XTreeWidgetPopulator::cancel()
+{
+  QMutexLocker locker(&_mutex);
+  _cancelled = true;
+  _rows.clear();
+  _drained.wakeAll();
+}
+
+bool XTreeWidgetPopulator::isCancelled() const
+{
+  QMutexLocker locker(&_mutex);
+  return _cancelled;
+}
+
+bool XTreeWidgetPopulator::isDone() const
+{
+  QMutexLocker locker(&_mutex);
+  return _done;
+}
+
+bool XTreeWidgetPopulator::isMapped() const
+{
+  QMutexLocker locker(&_mutex);
+  return _mapped;
+}
+
+int XTreeWidgetPopulator::size() const
+{
+  QMutexLocker locker(&_mutex);
+  return _size;
+}
+
+int XTreeWidgetPopulator::decoded() const
+{
+  QMutexLocker locker(&_mutex);
+  return _decoded;
+}
+
+QSqlError XTreeWidgetPopulator::lastError() const
+{
+  QMutexLocker locker(&_mutex);
+  return _error;
+}
+
+XTreeWidgetColumnMap XTreeWidgetPopulator::columnMap() const
+{
+  QMutexLocker locker(&_mutex);
+  return _map;
+}
+
+QList<XTreeWidgetRow> XTreeWidgetPopulator::takeRows(int max)
+{
+  QMutexLocker locker(&_mutex);
+  _drained.wakeAll();
+  if (_rows.size() <= max)
+  {
+    QList<XTreeWidgetRow> result = _rows;
+    _rows.clear();
+    return result;
+  }
+
+  QList<XTreeWidgetRow> result = _rows.mid(0, max);
+  _rows.erase(_rows.begin(), _rows.begin() + max);
+  return result;
+}
+
+void XTreeWidgetPopulator::run(QSqlDatabase &db)
+{
+  if (! db.isOpen())
+  {
+    QMutexLocker locker(&_mutex);
+    _error = db.lastError();
+  }
+  else if (! isCancelled())
+  {
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if (query.prepare(_sql))
+    {
+      QMapIterator<QString, QVariant> bind(_bindings);
+      while (bind.hasNext())
+      {
+        bind.next();
+        query.bindValue(bind.key(), bind.value());
+      }
+      query.exec();
+    }
+
+    if (query.lastError().type() != QSqlError::NoError)
+    {
+      QMutexLocker locker(&_mutex);
+      _error = query.lastError();
+    }
+    else if (query.first() && ! isCancelled())
+    {
+      XTreeWidgetColumnMap map;
+      map.build(query.record(), _colnames, _headerScales,
+                _headerAlignments, _decorated);
+      {
+        QMutexLocker locker(&_mutex);
+        _map    = map;
+        _mapped = true;
+        _size   = query.size();
+      }
+
+      QList<XTreeWidgetRow> batch;
+      bool cancelled = false;
+      do
+      {
+        XTreeWidgetRow row;
+        XTreeWidgetRow::decode(query, _useAltId, map, _formats, row);
+        batch.append(row);
+        if (batch.size() >= BATCHROWS)
+        {
+          // don't hold a second copy of a huge result; let the GUI catch up
+          QMutexLocker locker(&_mutex);
+          while (_rows.size() >= MAXBUFFERED && ! _cancelled)
+            _drained.wait(&_mutex);
+          cancelled = _cancelled;
+          if (! cancelled)
+          {
+            _rows     += batch;
+            _decoded  += batch.size();
+          }
+          batch.clear();
+        }
+      } while (! cancelled && query.next());
+
+      QMutexLocker locker(&_mutex);
+      if (! _cancelled)
+      {
+        _rows    += batch;
+        _decoded += batch.size();
+      }
+    }
+  }
+
+  QMutexLocker locker(&_mutex);
+  _done = true;
+}
@@ -0,0 +1,264 @@
+/*
+ * This file is part of the xTuple ERP: PostBooks Edition, a free and
+ * open source Enterprise Resource Planning software suite,
+ * Copyright (c) 1999-2014 by OpenMFG LLC, d/b/a xTuple.
+ * It is licensed to you under the Common Public Attribution License
+ * version 1.0, the full text of which (including xTuple-specific Exhibits)
+ * is available at www.xtuple.com/CPAL.  By using this software, you agree
+ * to be bound by its terms.
+ */
+
+#ifndef __XTREEWIDGETPOPULATOR_H__
+#define __XTREEWIDGETPOPULATOR_H__
+
+#include <QColor>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QPointer>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "xsqlconnectionpool.h"
+#include "xtreewidget.h"
+
+class QSqlQuery;
+
+/* make sure the colroles are kept in sync with
+   knownroles in XTreeWidgetColumnMap::build(),
+   both in count and order
+   */
+#define COLROLE_DISPLAY       0
+#define COLROLE_TEXTALIGNMENT 1
+#define COLROLE_BACKGROUND    2
+#define COLROLE_FOREGROUND    3
+#define COLROLE_TOOLTIP       4
+#define COLROLE_STATUSTIP     5
+#define COLROLE_FONT          6
+#define COLROLE_KEY           7
+#define COLROLE_RUNNING       8
+#define COLROLE_RUNNINGINIT   9
+#define COLROLE_GROUPRUNNING  10
+#define COLROLE_TOTAL         11
+#define COLROLE_NUMERIC       12
+#define COLROLE_NULL          13
+#define COLROLE_ID            14
+// make sure COLROLE_COUNT = last COLROLE + 1
+#define COLROLE_COUNT         15
+
+/* the result of matching the XTreeWidget's column definitions against
+   the fields of a query result. built once per populate, read-only after.
+ */
+class XTreeWidgetColumnMap
+{
+  public:
+    XTreeWidgetColumnMap();
+
+    void build(const QSqlRecord &record, const QStringList &colnames,
+               const QVector<int> &headerScales,
+               const QVector<int> &headerAlignments, bool decorated);
+
+    QVector<int>           colIdx;    // querycol = colIdx[xtreecol]
+    QVector<QVector<int> > colRole;   // querycol = colRole[xtreecol][COLROLE_*]
+    QVector<QVariantMap>   roleNames; // knownrole -> field name, per xtreecol
+    QVector<bool>          valid;     // false if the xtreecol has no role
+    QVector<int>           alignment; // header text alignment, per xtreecol
+    int                    rowRole[ROWROLE_COUNT];
+    int                    fieldCount;
+};
+
+/* running or total values for one column, one entry per set. there are
+   rarely more than a few sets so a linear search beats a QMap.
+ */
+class XTreeWidgetAccumulator
+{
+  public:
+    void    clear() { sets.clear(); values.clear(); }
+    int     indexOf(int set) const { return sets.indexOf(set); }
+    double &value(int set, double init = 0.0);
+
+    QVector<int>    sets;
+    QVector<double> values;
+};
+
+/* what XTreeWidget keeps between populate batches and sorts so
+   xtrunningrole and xttotalrole columns can be updated incrementally.
+ */
+class XTreeWidgetCalculations
+{
+  public:
+    XTreeWidgetCalculations(int columns)
+      : running(columns), totals(columns), totalScale(columns, 0),
+        stale(false), totalsStale(false) {}
+
+    // columns added after the first populate need their own slots
+    void resize(int columns)
+    {
+      running.resize(columns);
+      totals.resize(columns);
+      totalScale.resize(columns);
+    }
+
+    QVector<XTreeWidgetAccumulator>     running;
+    QVector<XTreeWidgetAccumulator>     totals;
+    QVector<int>                        totalScale;
+    QList<QPointer<XTreeWidgetItem> >   totalItems;
+    bool stale;       // top level running values must be redone from row 0
+    bool totalsStale; // an item's raw value or total init changed
+};
+
+/* a pre-digested copy of one cell's Xt::RawRole, cheap to compare.
+   sortItems() builds one per top-level item and sorts these.
+ */
+class XTreeWidgetSortKey
+{
+  public:
+    enum SortRank { SortNumber, SortText, SortNull };
+
+    XTreeWidgetSortKey() : rank(SortNull), number(0.0), numeric(false), item(0) {}
+    XTreeWidgetSortKey(const QVariant &value, XTreeWidgetItem *pItem = 0);
+
+    static bool lessThan(const XTreeWidgetSortKey &a, const XTreeWidgetSortKey &b);
+
+    SortRank         rank;
+    double           number;
+    bool             numeric; // a number type, not text that parses as one
+    QString          text;
+    XTreeWidgetItem *item;
+};
+
+/* everything XTreeWidget needs to know to build one XTreeWidgetItem,
+   decoded from the query without touching any widget.
+ */
+class XTreeWidgetCell
+{
+  public:
+    XTreeWidgetCell() : sortNumber(0.0),
+                        sortRank(XTreeWidgetSortKey::SortNull), sortNumeric(false),
+                        scale(-1), runningSet(0), totalSet(0),
+                        hasRunningSet(false), hasTotalSet(false) {}
+
+    QVariant raw;
+    QVariant display;
+    QVariant alignment;
+    QVariant foreground;
+    QVariant background;
+    QVariant toolTip;
+    QVariant statusTip;
+    QVariant font;
+    QVariant runningInit;
+    QVariant id;
+    double   sortNumber;
+    int      sortRank;
+    bool     sortNumeric;
+    int      scale;
+    int      runningSet;
+    int      totalSet;
+    bool     hasRunningSet;
+    bool     hasTotalSet;
+};
+
+/* the locale's numeric scales and named colors, read on the GUI thread.
+   decimalPlaces() and namedColor() may load the locale through the GUI
+   thread's database connection, so decode() uses a copy of this instead.
+ */
+class XTreeWidgetFormats
+{
+  public:
+    XTreeWidgetFormats();
+
+    int    scale(const QString &name) const;
+    QColor color(const QString &name) const;
+
+    int defaultScale;
+
+  private:
+    QHash<QString, int>    _scales;
+    QHash<QString, QColor> _colors;
+};
+
+class XTreeWidgetRow
+{
+  public:
+    XTreeWidgetRow() : id(-1), altId(-1), indent(0),
+                       hidden(false), deleted(false), allNull(false) {}
+
+    static void decode(const QSqlQuery &query, bool useAltId,
+                       const XTreeWidgetColumnMap &map,
+                       const XTreeWidgetFormats &formats, XTreeWidgetRow &row);
+    static QString formatNumber(double value, int scale);
+
+    int  id;
+    int  altId;
+    int  indent;
+    bool hidden;
+    bool deleted;
+    bool allNull;
+    QVector<XTreeWidgetCell> cells;
+};
+
+/* Run a populate query on an XSqlConnectionPool connection and decode
+   the result into XTreeWidgetRows. The GUI thread collects finished rows
+   with takeRows() and turns them into items. The worker pauses while too
+   many decoded rows are waiting to be taken.
+ */
+class XTreeWidgetPopulator : public XSqlPoolTask
+{
+  Q_OBJECT
+
+  public:
+    XTreeWidgetPopulator(QObject *parent = 0);
+    ~XTreeWidgetPopulator();
+
+    void setQuery(const QString &sql, const QVariantMap &bindings);
+    void setColumns(const QStringList &colnames,
+                    const QVector<int> &headerScales,
+                    const QVector<int> &headerAlignments, bool decorated);
+    void setUseAltId(bool useAltId);
+    void setFormats(const XTreeWidgetFormats &formats);
+
+    void  cancel();
+    bool  isCancelled() const;
+    bool  isDone() const;
+    bool  isMapped() const;
+    int   size() const;
+    int   decoded() const;
+    QSqlError lastError() const;
+    XTreeWidgetColumnMap columnMap() const;
+    QList<XTreeWidgetRow> takeRows(int max);
+
+    static bool canRunThreaded();
+
+  protected:
+    virtual void run(QSqlDatabase &db);
+
+  private:
+    mutable QMutex        _mutex;
+    QString               _sql;
+    QVariantMap           _bindings;
+    QStringList           _colnames;
+    QVector<int>          _headerScales;
+    QVector<int>          _headerAlignments;
+    bool                  _decorated;
+    bool                  _useAltId;
+    XTreeWidgetFormats    _formats;
+
+    // shared with the GUI thread, guarded by _mutex
+    bool                  _cancelled;
+    bool                  _done;
+    bool                  _mapped;
+    int                   _size;
+    int                   _decoded;
+    QSqlError             _error;
+    XTreeWidgetColumnMap  _map;
+    QList<XTreeWidgetRow> _rows;
+    QWaitCondition        _drained;  // takeRows() or cancel() made room
+};
+
+#endif